@@ -0,0 +1,458 @@
+// Measures the core operations of the library at several world sizes and prints the results as JSON.
+//
+// Usage: ecs_bench [--sizes 10000,100000,1000000] [--repeat 3] [--filter name]
+//
+// Every scenario runs repeat times on a fresh world and the median time is reported.
+// The random number generator uses a fixed seed so the runs are reproducible.
+// Each scenario and size runs in its own child process, so the peak resident set size of a row
+// only covers that row. On Windows the rows run in the same process, and the working set right
+// before the last world of the row is freed is reported instead.
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ecs.h"
+
+#if defined(_WIN32)
+#define PSAPI_VERSION 2
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#endif
+
+#define BENCH_COMPONENT_COUNT 8
+#define BENCH_MAX_SIZES 16
+#define BENCH_MAX_REPEAT 32
+#define BENCH_SET_COUNT 64
+
+typedef struct BenchValue {
+    float x, y, z, w;
+} BenchValue;
+
+// The state of a single run of a scenario.
+typedef struct BenchRun {
+    EcsWorld world;
+    int entity_count;
+
+    // The number of operations measured by the run, and the time they took.
+    long long ops;
+    long long ns;
+    long long start;
+
+    // Written by the scenarios so the compiler can't remove the work being measured.
+    double sink;
+} BenchRun;
+
+typedef void (*BenchScenario)(BenchRun* run);
+
+static EcsComponentManager* components[BENCH_COMPONENT_COUNT];
+static unsigned int random_state;
+
+static unsigned int bench_random(void) {
+    // xorshift32
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+    return random_state;
+}
+
+static long long bench_now(void) {
+#if defined(_WIN32)
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (long long)(counter.QuadPart * (1000000000.0 / frequency.QuadPart));
+#else
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (long long)time.tv_sec * 1000000000LL + time.tv_nsec;
+#endif
+}
+
+// Gets the largest resident set size of the process so far, in kilobytes.
+// The peak can't be reset on Windows, so the current working set is used there instead.
+static long long bench_peak_rss_kb(void) {
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters;
+    if(!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return -1;
+
+    return (long long)(counters.WorkingSetSize / 1024);
+#else
+    struct rusage usage;
+    if(getrusage(RUSAGE_SELF, &usage) != 0)
+        return -1;
+
+#if defined(__APPLE__)
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+#endif
+}
+
+static void bench_begin(BenchRun* run) {
+    run->start = bench_now();
+}
+
+static void bench_end(BenchRun* run, long long ops) {
+    run->ns += bench_now() - run->start;
+    run->ops += ops;
+}
+
+static EcsEntity* bench_create_entities(BenchRun* run, int component_count) {
+    EcsEntity* entities = ecs_malloc(sizeof(EcsEntity) * run->entity_count);
+    for(int i = 0; i < run->entity_count; i++) {
+        entities[i] = ecs_create_entity(run->world);
+        for(int c = 0; c < component_count; c++)
+            *(BenchValue*)ecs_component_set(entities[i], components[c]) = (BenchValue){ (float)(bench_random() & 0xFF), 0, 0, 0 };
+    }
+
+    return entities;
+}
+
+static void scenario_entity_create(BenchRun* run) {
+    bench_begin(run);
+    for(int i = 0; i < run->entity_count; i++)
+        ecs_create_entity(run->world);
+    bench_end(run, run->entity_count);
+}
+
+// Frees every entity, then creates them again so the freed ids are reused.
+static void scenario_entity_churn(BenchRun* run) {
+    EcsEntity* entities = bench_create_entities(run, 1);
+
+    bench_begin(run);
+    for(int i = 0; i < run->entity_count; i++)
+        ecs_entity_free(entities[i]);
+    for(int i = 0; i < run->entity_count; i++)
+        entities[i] = ecs_create_entity(run->world);
+    bench_end(run, 2LL * run->entity_count);
+
+    ecs_free(entities);
+}
+
+static void scenario_component_set(BenchRun* run) {
+    EcsEntity* entities = bench_create_entities(run, 0);
+
+    bench_begin(run);
+    for(int i = 0; i < run->entity_count; i++)
+        ecs_component_set(entities[i], components[0]);
+    bench_end(run, run->entity_count);
+
+    ecs_free(entities);
+}
+
+static void scenario_component_remove(BenchRun* run) {
+    EcsEntity* entities = bench_create_entities(run, 1);
+
+    bench_begin(run);
+    for(int i = 0; i < run->entity_count; i++)
+        ecs_component_remove(entities[i], components[0]);
+    bench_end(run, run->entity_count);
+
+    ecs_free(entities);
+}
+
+// Adds and removes a component from random entities while a few sets listen for the changes.
+static void scenario_component_churn(BenchRun* run) {
+    EcsEntity* entities = bench_create_entities(run, 2);
+
+    EcsEntitySet* sets[3];
+    for(int i = 0; i < 3; i++) {
+        EcsEntitySetBuilder* builder = ecs_entity_set_builder_init();
+        ecs_entity_set_with(builder, components[i]);
+        sets[i] = ecs_entity_set_build(builder, run->world, true);
+    }
+
+    bench_begin(run);
+    for(int i = 0; i < run->entity_count; i++) {
+        EcsEntity entity = entities[bench_random() % run->entity_count];
+        if(ecs_component_has(entity, components[2]))
+            ecs_component_remove(entity, components[2]);
+        else
+            ecs_component_set(entity, components[2]);
+    }
+    bench_end(run, run->entity_count);
+
+    for(int i = 0; i < 3; i++)
+        ecs_entity_set_free(sets[i]);
+
+    ecs_free(entities);
+}
+
+// Builds a set for a component that only 1% of the entities own.
+static void scenario_entity_set_build(BenchRun* run) {
+    EcsEntity* entities = bench_create_entities(run, 1);
+    for(int i = 0; i < run->entity_count; i += 100)
+        ecs_component_set(entities[i], components[1]);
+
+    bench_begin(run);
+    EcsEntitySetBuilder* builder = ecs_entity_set_builder_init();
+    ecs_entity_set_with(builder, components[0]);
+    ecs_entity_set_with(builder, components[1]);
+    EcsEntitySet* set = ecs_entity_set_build(builder, run->world, true);
+    bench_end(run, 1);
+
+    ecs_entity_set_free(set);
+    ecs_free(entities);
+}
+
+static void bench_sum_components(void* data, EcsEntity entity, void** values) {
+    BenchRun* run = data;
+    run->sink += ((BenchValue*)values[0])->x;
+}
+
+// Iterates over the entities that own the first query_size components, resolving every component of each entity.
+static void bench_query(BenchRun* run, int query_size) {
+    EcsEntity* entities = bench_create_entities(run, BENCH_COMPONENT_COUNT);
+
+    EcsEntitySetBuilder* builder = ecs_entity_set_builder_init();
+    for(int c = 0; c < query_size; c++)
+        ecs_entity_set_with(builder, components[c]);
+    EcsEntitySet* set = ecs_entity_set_build(builder, run->world, true);
+
+    bench_begin(run);
+    ecs_entity_set_each(set, components, query_size, bench_sum_components, run);
+    bench_end(run, run->entity_count);
+
+    ecs_entity_set_free(set);
+    ecs_free(entities);
+}
+
+static void scenario_query_1(BenchRun* run) {
+    bench_query(run, 1);
+}
+
+static void scenario_query_2(BenchRun* run) {
+    bench_query(run, 2);
+}
+
+static void scenario_query_4(BenchRun* run) {
+    bench_query(run, 4);
+}
+
+static void scenario_query_8(BenchRun* run) {
+    bench_query(run, 8);
+}
+
+// Every entity shares the component of a single owner.
+static void scenario_shared_component_get(BenchRun* run) {
+    EcsEntity* entities = bench_create_entities(run, 0);
+    *(BenchValue*)ecs_component_set(entities[0], components[0]) = (BenchValue){ 1, 0, 0, 0 };
+    for(int i = 1; i < run->entity_count; i++)
+        ecs_component_set_same_as(entities[i], entities[0], components[0]);
+
+    bench_begin(run);
+    for(int i = 0; i < run->entity_count; i++)
+        run->sink += ((BenchValue*)ecs_component_try_get(entities[i], components[0]))->x;
+    bench_end(run, run->entity_count);
+
+    ecs_free(entities);
+}
+
+// Adds and removes a component while many sets with different filters exist on the world.
+static void scenario_many_entity_sets(BenchRun* run) {
+    EcsEntity* entities = bench_create_entities(run, 1);
+
+    EcsEntitySet* sets[BENCH_SET_COUNT];
+    for(int i = 0; i < BENCH_SET_COUNT; i++) {
+        EcsEntitySetBuilder* builder = ecs_entity_set_builder_init();
+        ecs_entity_set_with(builder, components[i % BENCH_COMPONENT_COUNT]);
+        ecs_entity_set_without(builder, components[(i / BENCH_COMPONENT_COUNT + i + 1) % BENCH_COMPONENT_COUNT]);
+        sets[i] = ecs_entity_set_build(builder, run->world, true);
+    }
+
+    bench_begin(run);
+    for(int i = 0; i < run->entity_count; i++)
+        ecs_component_set(entities[i], components[1]);
+    for(int i = 0; i < run->entity_count; i++)
+        ecs_component_remove(entities[i], components[1]);
+    bench_end(run, 2LL * run->entity_count);
+
+    for(int i = 0; i < BENCH_SET_COUNT; i++)
+        ecs_entity_set_free(sets[i]);
+
+    ecs_free(entities);
+}
+
+static BenchRun* bench_system_run;
+
+static void bench_system_update(EcsComponentSystem* system, float delta, void* first, int count) {
+    BenchValue* values = first;
+    for(int i = 0; i < count; i++) {
+        values[i].y += values[i].x * delta;
+        bench_system_run->sink += values[i].y;
+    }
+}
+
+static void scenario_system_update(BenchRun* run) {
+    EcsEntity* entities = bench_create_entities(run, 1);
+
+    EcsComponentSystem system;
+    ecs_component_system_init_batch(&system, run->world, components[0], bench_system_update, NULL, NULL);
+    bench_system_run = run;
+
+    bench_begin(run);
+    ecs_system_update(&system.base, 1.0f / 60.0f);
+    bench_end(run, run->entity_count);
+
+    ecs_system_free_resources(&system.base);
+    ecs_free(entities);
+}
+
+typedef struct BenchDefinition {
+    const char* name;
+    BenchScenario scenario;
+} BenchDefinition;
+
+static const BenchDefinition scenarios[] = {
+    { "entity_create", scenario_entity_create },
+    { "entity_churn", scenario_entity_churn },
+    { "component_set", scenario_component_set },
+    { "component_remove", scenario_component_remove },
+    { "component_churn", scenario_component_churn },
+    { "entity_set_build", scenario_entity_set_build },
+    { "query_1", scenario_query_1 },
+    { "query_2", scenario_query_2 },
+    { "query_4", scenario_query_4 },
+    { "query_8", scenario_query_8 },
+    { "shared_component_get", scenario_shared_component_get },
+    { "many_entity_sets", scenario_many_entity_sets },
+    { "system_update", scenario_system_update }
+};
+
+static int compare_times(const void* left, const void* right) {
+    long long a = *(const long long*)left;
+    long long b = *(const long long*)right;
+    return a < b ? -1 : a > b;
+}
+
+static int parse_sizes(const char* text, int* sizes) {
+    int count = 0;
+    while(*text != '\0' && count < BENCH_MAX_SIZES) {
+        char* end;
+        long size = strtol(text, &end, 10);
+        if(end == text || size <= 0)
+            return 0;
+
+        sizes[count++] = (int)size;
+        text = *end == ',' ? end + 1 : end;
+    }
+
+    return count;
+}
+
+// Runs a scenario at one size and prints its result as a JSON object.
+static void bench_row(const BenchDefinition* definition, int entity_count, int repeat) {
+    long long times[BENCH_MAX_REPEAT];
+    long long ops = 0;
+    long long rss = 0;
+    double sink = 0;
+
+    for(int r = 0; r < repeat; r++) {
+        random_state = 0x9E3779B9u;
+
+        BenchRun run = { ecs_world_init(), entity_count, 0, 0, 0, 0 };
+        definition->scenario(&run);
+        rss = bench_peak_rss_kb();
+        ecs_world_free(run.world);
+
+        times[r] = run.ns;
+        ops = run.ops;
+        sink += run.sink;
+    }
+
+    qsort(times, repeat, sizeof(long long), compare_times);
+    long long ns = times[repeat / 2];
+    double ns_per_op = ops == 0 ? 0.0 : (double)ns / (double)ops;
+    double ops_per_sec = ns == 0 ? 0.0 : (double)ops * 1e9 / (double)ns;
+
+    printf("\n    { \"scenario\": \"%s\", \"entities\": %d, \"ops\": %lld, \"ns\": %lld, "
+           "\"ns_per_op\": %.3f, \"ops_per_sec\": %.1f, \"peak_rss_kb\": %lld, \"checksum\": %.1f }",
+           definition->name,
+           entity_count,
+           ops,
+           ns,
+           ns_per_op,
+           ops_per_sec,
+           rss,
+           sink);
+    fflush(stdout);
+}
+
+int main(int argc, char** argv) {
+    int sizes[BENCH_MAX_SIZES] = { 10000, 100000, 1000000 };
+    int size_count = 3;
+    int repeat = 3;
+    const char* filter = NULL;
+
+    for(int i = 1; i < argc; i++) {
+        if(strcmp(argv[i], "--sizes") == 0 && i + 1 < argc) {
+            size_count = parse_sizes(argv[++i], sizes);
+        } else if(strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+            repeat = atoi(argv[++i]);
+        } else if(strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            filter = argv[++i];
+        } else {
+            fprintf(stderr, "Usage: %s [--sizes 10000,100000,1000000] [--repeat 3] [--filter name]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if(size_count == 0 || repeat < 1 || repeat > BENCH_MAX_REPEAT) {
+        fprintf(stderr, "Invalid sizes or repeat count\n");
+        return EXIT_FAILURE;
+    }
+
+    ecs_init();
+    for(int c = 0; c < BENCH_COMPONENT_COUNT; c++)
+        components[c] = ecs_component_define(sizeof(BenchValue), NULL, NULL);
+
+    printf("{\n  \"repeat\": %d,\n  \"results\": [", repeat);
+    bool first = true;
+
+    for(int s = 0; s < (int)(sizeof(scenarios) / sizeof(*scenarios)); s++) {
+        if(filter != NULL && strstr(scenarios[s].name, filter) == NULL)
+            continue;
+
+        for(int size = 0; size < size_count; size++) {
+            printf("%s", first ? "" : ",");
+            fflush(stdout);
+            first = false;
+
+#if defined(_WIN32)
+            bench_row(scenarios + s, sizes[size], repeat);
+#else
+            // The child starts from the small footprint of this process, so its peak only covers the row.
+            pid_t child = fork();
+            if(child == 0) {
+                bench_row(scenarios + s, sizes[size], repeat);
+                _exit(EXIT_SUCCESS);
+            }
+
+            int status;
+            if(child < 0 || waitpid(child, &status, 0) != child || !WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS) {
+                fprintf(stderr, "Scenario %s failed at %d entities\n", scenarios[s].name, sizes[size]);
+                return EXIT_FAILURE;
+            }
+#endif
+        }
+    }
+
+    printf("\n  ]\n}\n");
+
+    for(int c = 0; c < BENCH_COMPONENT_COUNT; c++)
+        ecs_component_free(components[c]);
+
+    return EXIT_SUCCESS;
+}
\ No newline at end of file
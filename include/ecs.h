@@ -11,15 +11,21 @@
 #define ECS_ECS_H
 
 #include "ecs_common.h"
+#include "ecs_context.h"
 #include "ecs_entity.h"
 #include "ecs_int_dispenser.h"
+#include "ecs_sparse_map.h"
 #include "ecs_component_flag.h"
 #include "ecs_component.h"
+#include "ecs_component_group.h"
 #include "ecs_messages.h"
 #include "ecs_system.h"
 #include "ecs_event.h"
 #include "ecs_world.h"
 #include "ecs_entity_set.h"
+#include "ecs_archetype.h"
+#include "ecs_command_buffer.h"
+#include "ecs_job.h"
 
 /// Initializes the various systems needed to use ecs.
 void ecs_init(void);
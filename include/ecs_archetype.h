@@ -0,0 +1,104 @@
+/*!
+ * @file
+ *
+ * \brief Table based storage for component types defined with ecs_component_define_archetype.
+ *
+ * Entities that own exactly the same set of archetype components are stored together
+ * in a table (an archetype) that has one column per component type. A query over several archetype
+ * components walks the columns of every matching table, so there is no lookup per entity or per component.
+ *
+ * Moving an entity between tables copies its components, so pointers to archetype components
+ * are only valid until an archetype component is added to or removed from the same entity,
+ * or another entity is removed from the same table.
+ */
+#ifndef ECS_ARCHETYPE_H
+#define ECS_ARCHETYPE_H
+
+#include "ecs_common.h"
+#include "ecs_entity.h"
+#include "ecs_component.h"
+
+/// A cached query over the archetype tables of a world.
+typedef struct EcsArchetypeQuery EcsArchetypeQuery;
+
+/// Iterates over the tables that match an EcsArchetypeQuery.
+typedef struct EcsArchetypeIterator {
+    /// The entities stored in the current table.
+    EcsEntity* entities;
+
+    /// One array per with component of the query, in the order they were passed to ecs_archetype_query_init.
+    /// Each array holds count components. Cast each array to the type of its component.
+    void** columns;
+
+    /// The number of entities in the current table.
+    int count;
+
+/// \privatesection
+    EcsArchetypeQuery* query;
+    int table;
+} EcsArchetypeIterator;
+
+/// Initializes the archetype subsystem. Should not be called directly.
+void ecs_archetype_system_init(void);
+
+/// Frees the archetype subsystem of the current context. Should not be called directly.
+void ecs_archetype_system_free(void);
+
+/*!
+    \brief Creates a query over all entities that own a set of archetype components.
+
+    Every manager in the with and without arrays must have been defined with ecs_component_define_archetype.
+    Disabled entities are still stored in their tables, so they are visited by the query.
+
+    \param world The world to query.
+    \param with The component types an entity must own. Determines the order of EcsArchetypeIterator::columns.
+    \param with_count The number of component types in the with array.
+    \param without The component types an entity can't own. Can be NULL if without_count is 0.
+    \param without_count The number of component types in the without array.
+    \return A new query, or NULL if a with or without component isn't stored in archetypes.
+ */
+EcsArchetypeQuery* ecs_archetype_query_init(EcsWorld world,
+                                            EcsComponentManager** with,
+                                            int with_count,
+                                            EcsComponentManager** without,
+                                            int without_count);
+
+/// Frees an EcsArchetypeQuery.
+void ecs_archetype_query_free(EcsArchetypeQuery* query);
+
+/*!
+    \brief Starts iterating over the tables that match a query.
+
+    Tables created since the last iteration are matched against the query before the iteration starts.
+    Only one iteration can be active per query at a time.
+
+    \param query The query to iterate over.
+    \param iterator The iterator to initialize.
+ */
+void ecs_archetype_query_iter(EcsArchetypeQuery* query, EcsArchetypeIterator* iterator);
+
+/// Moves an iterator to the next non-empty matching table. Returns false when there are no tables left.
+bool ecs_archetype_iter_next(EcsArchetypeIterator* iterator);
+
+/// \private
+/// Makes room for an archetype component on an entity and returns its address without constructing it.
+/// Sets added to false if the entity already owned the component.
+void* ecs_archetype_set(EcsEntity entity, EcsComponentManager* manager, bool* added);
+
+/// \private
+/// Moves an entity to the table without the specified component. The component must already be destroyed.
+bool ecs_archetype_remove(EcsEntity entity, EcsComponentManager* manager);
+
+/// \private
+/// Gets the address of an archetype component, or NULL if the entity doesn't own it.
+void* ecs_archetype_get(EcsEntity entity, EcsComponentManager* manager);
+
+/// \private
+/// Gets the column of the nth non-empty table that stores the specified component type.
+void* ecs_archetype_get_column(EcsWorld world, EcsComponentManager* manager, int column, int* count);
+
+/// \private
+/// Destroys and removes a component type from every entity on a world.
+void ecs_archetype_clear(EcsWorld world, EcsComponentManager* manager);
+
+#endif
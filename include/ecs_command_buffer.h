@@ -0,0 +1,88 @@
+/*!
+ * @file
+ *
+ * \brief Records structural changes to a world so they can be applied later.
+ *
+ * Creating or freeing entities and adding or removing components publishes events that update
+ * every EcsEntitySet on the world. Doing that while a system is iterating over a set can skip
+ * or revisit entities. An EcsCommandBuffer records those changes instead, and applies them all
+ * at once when ecs_command_buffer_playback is called outside of the iteration.
+ *
+ * A command buffer is not thread safe, but command buffers don't share any state,
+ * so each thread can record into its own buffer at the same time. The buffers should
+ * then be played back one after another from a single thread.
+ */
+#ifndef ECS_COMMAND_BUFFER_H
+#define ECS_COMMAND_BUFFER_H
+
+#include "ecs_common.h"
+#include "ecs_entity.h"
+#include "ecs_component.h"
+
+/// Records structural changes to a world and applies them in a single batch.
+typedef struct EcsCommandBuffer EcsCommandBuffer;
+
+/// Creates a new EcsCommandBuffer that records changes to the specified world.
+EcsCommandBuffer* ecs_command_buffer_init(EcsWorld world);
+
+/// Frees an EcsCommandBuffer. Any commands that haven't been played back are discarded, destroying the component values they recorded.
+void ecs_command_buffer_free(EcsCommandBuffer* buffer);
+
+/*!
+    \brief Records the creation of an entity.
+
+    \param buffer The buffer to record the command into.
+    \return A placeholder entity that can be passed to the other commands of the same buffer.
+            The placeholder is replaced by the created entity during playback,
+            and can be converted to it afterwards using ecs_command_buffer_resolve.
+ */
+EcsEntity ecs_command_buffer_create_entity(EcsCommandBuffer* buffer);
+
+/// Records freeing an entity. Every other command recorded for the entity is discarded.
+void ecs_command_buffer_free_entity(EcsCommandBuffer* buffer, EcsEntity entity);
+
+/*!
+    \brief Records adding a component to an entity.
+
+    \param buffer The buffer to record the command into.
+    \param entity The entity to add the component to.
+    \param manager The type of the component.
+    \param data The value of the component. Can be NULL to only construct the component.
+                Otherwise the bytes are copied into the buffer. During playback the constructed component
+                is destroyed and replaced with the copy, so data should be a fully constructed component
+                whose resources are owned by the buffer afterwards. If the command is overridden by a later command
+                of the same entity, or is never played back, the copy is destroyed with the destructor of the
+                component type instead. For component types defined with
+                ecs_component_define_aligned, data must include the padding at the end of the component.
+ */
+void ecs_command_buffer_set(EcsCommandBuffer* buffer, EcsEntity entity, EcsComponentManager* manager, const void* data);
+
+/// Records removing a component from an entity.
+void ecs_command_buffer_remove(EcsCommandBuffer* buffer, EcsEntity entity, EcsComponentManager* manager);
+
+/// Records enabling an entity.
+void ecs_command_buffer_enable(EcsCommandBuffer* buffer, EcsEntity entity);
+
+/// Records disabling an entity.
+void ecs_command_buffer_disable(EcsCommandBuffer* buffer, EcsEntity entity);
+
+/// Gets the number of commands that are waiting to be played back.
+int ecs_command_buffer_count(EcsCommandBuffer* buffer);
+
+/*!
+    \brief Applies every recorded command to the world, then clears the buffer.
+
+    Entities are created first. The remaining commands are sorted by entity so that the changes
+    to each entity are applied together, in the order they were recorded. Commands that are overridden
+    by a later command are skipped: only the last set or remove of each component type is applied,
+    only the last enable or disable is applied, and nothing but the free is applied to a freed entity.
+
+    \param buffer The buffer to play back.
+ */
+void ecs_command_buffer_playback(EcsCommandBuffer* buffer);
+
+/// Gets the entity that was created for a placeholder returned by ecs_command_buffer_create_entity
+/// during the last playback. Entities that aren't placeholders are returned unchanged.
+EcsEntity ecs_command_buffer_resolve(EcsCommandBuffer* buffer, EcsEntity entity);
+
+#endif
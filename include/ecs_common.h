@@ -5,6 +5,7 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include "ecs_array.h"
 
 // Originally these were defined to use the SDL version of each function if the library was
@@ -22,12 +23,85 @@
 #include <stdlib.h>
 #include <string.h>
 #define ecs_malloc malloc
+#define ecs_calloc calloc
 #define ecs_realloc realloc
 #define ecs_free free
 #define ecs_memmove memmove
 #define ecs_memcpy memcpy
 #define ecs_memset memset
 
+/// Marks a variable as having a separate value on every thread.
+#if defined(_MSC_VER)
+#define ECS_THREAD_LOCAL __declspec(thread)
+#else
+#define ECS_THREAD_LOCAL _Thread_local
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+/// Gets the index of the lowest set bit of a value, which must not be 0.
+static inline int ecs_bit_scan_forward64(uint64_t value) {
+#if defined(_MSC_VER) && defined(_WIN64)
+    unsigned long index;
+    _BitScanForward64(&index, value);
+    return (int)index;
+#elif defined(_MSC_VER)
+    unsigned long index;
+    if(_BitScanForward(&index, (unsigned long)value))
+        return (int)index;
+
+    _BitScanForward(&index, (unsigned long)(value >> 32));
+    return (int)index + 32;
+#else
+    return __builtin_ctzll(value);
+#endif
+}
+
+// Aligned allocations over-allocate with ecs_malloc and store the original address right before
+// the aligned block. An alignment of 0 falls back to the plain functions so that callers can use
+// the same code path for types that don't need extra alignment.
+
+/// Allocates size bytes at an address that is a multiple of alignment, which must be 0 or a power of two.
+static inline void* ecs_aligned_malloc(size_t size, size_t alignment) {
+    if(alignment == 0)
+        return ecs_malloc(size);
+
+    if(alignment < sizeof(void*))
+        alignment = sizeof(void*);
+
+    char* raw = ecs_malloc(size + alignment + sizeof(void*));
+    if(raw == NULL)
+        return NULL;
+
+    char* aligned = (char*)(((uintptr_t)raw + sizeof(void*) + alignment - 1) & ~(uintptr_t)(alignment - 1));
+    ((void**)aligned)[-1] = raw;
+    return aligned;
+}
+
+/// Frees memory allocated with ecs_aligned_malloc or ecs_aligned_realloc using the same alignment.
+static inline void ecs_aligned_free(void* ptr, size_t alignment) {
+    if(alignment == 0)
+        ecs_free(ptr);
+    else if(ptr != NULL)
+        ecs_free(((void**)ptr)[-1]);
+}
+
+/// Resizes an aligned allocation from old_size to new_size bytes, keeping its alignment.
+static inline void* ecs_aligned_realloc(void* ptr, size_t old_size, size_t new_size, size_t alignment) {
+    if(alignment == 0)
+        return ecs_realloc(ptr, new_size);
+
+    void* result = ecs_aligned_malloc(new_size, alignment);
+    if(result != NULL && ptr != NULL) {
+        ecs_memcpy(result, ptr, old_size < new_size ? old_size : new_size);
+        ecs_aligned_free(ptr, alignment);
+    }
+
+    return result;
+}
+
 /// A named constant that can be used to identify function success or cause of failure.
 typedef enum EcsResult {
     /// The function returned properly.
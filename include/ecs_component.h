@@ -5,6 +5,9 @@
 #include "ecs_event.h"
 #include "ecs_entity.h"
 #include "ecs_component_flag.h"
+#include "ecs_int_dispenser.h"
+#include "ecs_sparse_map.h"
+#include "ecs_world.h"
 
 /// Function definition used when a new component is created.
 typedef void (*EcsComponentConstructor)(void*);
@@ -12,13 +15,80 @@ typedef void (*EcsComponentConstructor)(void*);
 /// Function definition used when a component is destroyed.
 typedef void (*EcsComponentDestructor)(void*);
 
-struct EcsComponentPool;
+/// \private
+/// Links the entities that reference a component stored in an EcsComponentPool.
+typedef struct ComponentLink {
+/// \privatesection
+    // The owner of the component. When the component is shared, this is any entity in the sharer ring.
+    int entity_id;
+    int references;
+
+    // The share slot of the component if it is referenced by more than one entity, otherwise -1.
+    int share;
+} ComponentLink;
+
+/// Stores the components of a single component type on a single world.
+typedef struct EcsComponentPool {
+/// \privatesection
+    int world;
+    int component_size;
+    int alignment;
+    char* components;
+    int component_count;
+
+    // When chunk_shift is non-zero, the components are stored in blocks of (1 << chunk_shift)
+    // components instead of the single components array. component_count is still the total capacity.
+    char** chunks;
+    int chunk_capacity;
+    int chunk_shift;
+
+    // The world tick at which each component was last changed, indexed the same as the components.
+    // Only allocated if the component type tracks changes, in which case it has component_count elements.
+    unsigned int* versions;
+    bool track_changes;
+
+    // Maps an entity id to either a component index (value << 1)
+    // or to a share slot ((slot << 1) | 1) when the component is shared.
+    EcsSparseMap mapping;
+    ComponentLink* links;
+    int link_count;
+    int last_component_index;
+    int entity_disposed_id;
+
+    // Shared components are referenced through a share slot that stores the index of the component,
+    // so moving a shared component only requires updating its slot instead of every sharer.
+    int* share_targets;
+    int share_capacity;
+    EcsIntDispenser share_dispenser;
+
+    // A doubly linked ring of the entities that share each component.
+    EcsSparseMap share_next;
+    EcsSparseMap share_prev;
+
+    // The group that keeps this pool partitioned, or NULL if the pool isn't owned by a group.
+    struct EcsComponentGroup* group;
+} EcsComponentPool;
+
+/// Determines where the components of a component type are stored.
+typedef enum EcsComponentStorage {
+    /// The components are stored in a pool per world, either contiguously or in chunks.
+    ECS_COMPONENT_STORAGE_POOL,
+
+    /// The components are stored in archetype tables with the other archetype components of their entity.
+    ECS_COMPONENT_STORAGE_ARCHETYPE,
+
+    /// The component type has no data. Only the flag in the entity's ComponentEnum is stored.
+    ECS_COMPONENT_STORAGE_TAG
+} EcsComponentStorage;
 
 /// Defines and handles the memory management of a component type.
 typedef struct EcsComponentManager {
     /// The unique identifer of this component type.
     ComponentFlag flag;
 
+    /// Where the components of this type are stored.
+    EcsComponentStorage storage;
+
 /// \privatesection
 
     EcsComponentConstructor constructor;
@@ -26,14 +96,29 @@ typedef struct EcsComponentManager {
 
     EcsEventManager* added;
     EcsEventManager* removed;
+    EcsEventManager* added_many;
+    EcsEventManager* removed_many;
 
-    struct EcsComponentPool** pools;
+    EcsComponentPool** pools;
 
     int pool_count;
 
-    // The size of the component in bytes.
+    // Tags have no pools, so the entity disposed subscription of each world is stored here instead. -1 if not subscribed.
+    int* tag_subscriptions;
+    int tag_subscription_count;
+
+    // The distance between two components in bytes. A multiple of alignment if alignment isn't 0.
     int component_size;
 
+    // The alignment of the component storage in bytes, or 0 to use the alignment of ecs_malloc.
+    int alignment;
+
+    // The log2 of the number of components per chunk, or 0 if the components are stored contiguously.
+    int chunk_shift;
+
+    // Determines if the pools store the world tick at which each component was last written.
+    bool track_changes;
+
     int world_disposed_id;
 } EcsComponentManager;
 
@@ -47,12 +132,86 @@ typedef struct EcsComponentManager {
  */
 EcsComponentManager* ecs_component_define(int component_size, EcsComponentConstructor constructor, EcsComponentDestructor destructor);
 
+/*!
+  \brief Creates a new component type whose components are stored at a specific alignment.
+
+  The size of each component is padded to a multiple of the alignment, so every component in the array
+  returned by ecs_component_get_all (and ecs_component_get_chunk) starts at an aligned address.
+  Use this for types that need aligned SIMD loads, such as 16 or 32 byte vectors and matrices.
+
+  \param component_size The size of the component type. Used to allocate new components.
+  \param alignment The alignment of each component in bytes. Rounded up to the next power of two.
+  \param constructor A function that is called when a new component is created. Can be NULL.
+  \param destructor A function that is called when a component is removed. Can be NULL.
+  \return A new EcsComponentManager
+ */
+EcsComponentManager* ecs_component_define_aligned(int component_size, int alignment, EcsComponentConstructor constructor, EcsComponentDestructor destructor);
+
+/*!
+  \brief Creates a new component type whose components are stored in fixed-size chunks.
+
+  Growing a chunked pool allocates a new chunk instead of moving the existing components,
+  so a pointer returned by ecs_component_set or ecs_component_get stays valid until a component
+  of the same type is removed from the world (removal moves the last component into the freed slot).
+
+  \param component_size The size of the component type. Used to allocate new components.
+  \param chunk_size The number of components stored in each chunk. Rounded up to the next power of two, and at least 2.
+  \param constructor A function that is called when a new component is created. Can be NULL.
+  \param destructor A function that is called when a component is removed. Can be NULL.
+  \return A new EcsComponentManager
+ */
+EcsComponentManager* ecs_component_define_chunked(int component_size, int chunk_size, EcsComponentConstructor constructor, EcsComponentDestructor destructor);
+
+/*!
+  \brief Creates a new component type that is stored in archetype tables.
+
+  Entities with the same set of archetype components store them together, one column per component type.
+  Use an EcsArchetypeQuery (see ecs_archetype.h) to iterate over several archetype components at once.
+  Archetype components can't be shared with ecs_component_set_same_as.
+
+  \param component_size The size of the component type. Used to allocate new components.
+  \param constructor A function that is called when a new component is created. Can be NULL.
+  \param destructor A function that is called when a component is removed. Can be NULL.
+  \return A new EcsComponentManager
+ */
+EcsComponentManager* ecs_component_define_archetype(int component_size, EcsComponentConstructor constructor, EcsComponentDestructor destructor);
+
+/*!
+  \brief Creates a new tag component type that has no data.
+
+  Adding or removing a tag only changes the flag in the entity's ComponentEnum and publishes the
+  added and removed events, so no memory is allocated per entity or per world.
+  ecs_component_set returns NULL for tags, ecs_component_get sets data to NULL,
+  and tags can't be shared with ecs_component_set_same_as.
+
+  \return A new EcsComponentManager
+ */
+EcsComponentManager* ecs_component_define_tag(void);
+
+/*!
+  \brief Makes a component type store the world tick at which each component was last changed.
+
+  A component's version is set to the current world tick (see ecs_world_get_tick) when it is created
+  and whenever it is accessed with ecs_component_get_mut or ecs_component_mark_changed.
+  Writes through a pointer returned by any other function are not tracked.
+
+  Only pool storage (including chunked pools) supports change tracking, and it has to be enabled
+  before the component type is used on any world.
+
+  \param manager The component type to track.
+  \return ECS_RESULT_SUCCESS, or ECS_RESULT_INVALID_STATE if the component type can't be tracked anymore.
+ */
+EcsResult ecs_component_track_changes(EcsComponentManager* manager);
+
 /// Frees all components owned by a EcsComponentManager, then frees the manager.
 void ecs_component_free(EcsComponentManager* manager);
 
 /*!
   \brief Creates and associates a component with an entity.
 
+  If the component type is owned by an EcsComponentGroup, this can move the components of other entities
+  in every pool owned by the group, invalidating pointers previously returned for them.
+
   \return A pointer to the new component. This will be one level of indirection higher than the component type.
  */
 void* ecs_component_set(EcsEntity entity, EcsComponentManager* manager);
@@ -69,9 +228,39 @@ EcsResult ecs_component_set_same_as(EcsEntity entity, EcsEntity reference, EcsCo
 /// Removes a component from an entity.
 EcsResult ecs_component_remove(EcsEntity entity, EcsComponentManager* manager);
 
+/*!
+  \brief Creates and associates a component with every entity in an array.
+
+  The pool is grown once for the whole batch, and a single EcsComponentAddedManyMessage is published
+  after every component has been constructed. The per-entity added event is not published.
+  Entities that already own the component have it destroyed and constructed again.
+  For tags, only the entities that didn't have the tag yet are reported, and each of them only once.
+
+  \param entities The entities to add the component to. They must all belong to the same world.
+  \param count The number of entities in the array.
+  \param manager The component type.
+  \param components An array of at least count pointers that is filled with the new components. Can be NULL.
+ */
+EcsResult ecs_component_set_many(EcsEntity* entities, int count, EcsComponentManager* manager, void** components);
+
+/*!
+  \brief Removes a component from every entity in an array.
+
+  A single EcsComponentRemovedManyMessage is published with the entities that owned the component
+  before any of them are destroyed. Each entity is reported once, even if it's in the array more than once. The per-entity removed event is not published.
+
+  \param entities The entities to remove the component from. They must all belong to the same world.
+  \param count The number of entities in the array.
+  \param manager The component type.
+ */
+EcsResult ecs_component_remove_many(EcsEntity* entities, int count, EcsComponentManager* manager);
+
 /*!
   \brief Get a component associated with an entity.
 
+  The pointer is invalidated when a component of the same type is removed from any entity, and if the type is owned by
+  an EcsComponentGroup, when any component type owned by the group is added to or removed from any entity.
+
   \param entity The entity that owns the component.
   \param manager The type of the component to get.
   \param component A pointer that is filled with the component value. Should be two levels of indirection higher than the actual component type.
@@ -85,13 +274,190 @@ bool ecs_component_exists(EcsEntity entity, EcsComponentManager*);
 /*!
   \brief Gets all created components, regardless if they're enabled or not.
 
+  Only component types whose components are stored in a single array are supported. Component types
+  defined with ecs_component_define_chunked, ecs_component_define_archetype, or ecs_component_define_tag
+  return NULL with a count of 0. Use ecs_component_get_chunk to iterate over their components instead.
+
   \param world The world to get all of the components from.
   \param manager The type of the component to get.
   \param count An int pointer that is filled with the number of components.
-  \return An array that holds the components. Do not free this array.
+  \return An array that holds the components, or NULL if there are none or the component type isn't
+          stored in a single array. Do not free this array.
  */
 void* ecs_component_get_all(EcsWorld world, EcsComponentManager* manager, int* count);
 
+/*!
+  \brief Gets a component owned by an entity and marks it as changed.
+
+  Behaves like ecs_component_get, but also sets the version of the component to the current world tick
+  if the component type tracks changes.
+ */
+EcsResult ecs_component_get_mut(EcsEntity entity, EcsComponentManager* manager, void** data);
+
+/// Sets the version of a component owned by an entity to the current world tick.
+EcsResult ecs_component_mark_changed(EcsEntity entity, EcsComponentManager* manager);
+
+/// Determines if an entity owns a component that changed after the specified world tick.
+/// Always true for component types that don't track changes.
+bool ecs_component_changed_since(EcsEntity entity, EcsComponentManager* manager, unsigned int tick);
+
+/*!
+  \brief Gets the versions of the components in a chunk returned by ecs_component_get_chunk.
+
+  \param world The world to get the versions from.
+  \param manager The type of the component. Must track changes.
+  \param chunk The index of the chunk, starting at 0.
+  \param count An int pointer that is filled with the number of versions in the chunk.
+  \return An array that holds the version of each component in the chunk in the same order,
+          or NULL if the chunk is out of range or the component type doesn't track changes. Do not free this array.
+ */
+unsigned int* ecs_component_get_versions(EcsWorld world, EcsComponentManager* manager, int chunk, int* count);
+
+/*!
+  \brief Gets a contiguous block of created components, regardless if they're enabled or not.
+
+  Component types that aren't chunked are treated as a single chunk.
+  For archetype component types, each non-empty table that stores the component type is a chunk.
+  This never allocates, so systems reading different component types can call it from several threads at once.
+
+  \param world The world to get the components from.
+  \param manager The type of the component to get.
+  \param chunk The index of the chunk to get, starting at 0.
+  \param count An int pointer that is filled with the number of components in the chunk.
+  \return An array that holds the components of the chunk, or NULL if the chunk is out of range
+          or no entity on the world ever owned the component type. Do not free this array.
+ */
+void* ecs_component_get_chunk(EcsWorld world, EcsComponentManager* manager, int chunk, int* count);
+
+/// Compares two components when sorting a pool. Returns a negative value if left comes first,
+/// a positive value if right comes first, and 0 if their order doesn't matter.
+typedef int (*EcsComponentCompare)(const void* left, const void* right);
+
+/// Gets the key of a component when sorting a pool by key. Components are sorted by ascending key.
+typedef uint32_t (*EcsComponentSortKey)(const void* component);
+
+/*!
+  \brief Sorts the components of a component type on a world in place.
+
+  The components, their versions, and the mapping from their owners are moved together, so every
+  entity keeps its component. Components that compare equal keep their relative order.
+
+  \param world The world of the components to sort.
+  \param manager The type of the components. Must be stored in pools.
+  \param compare The function used to order the components.
+  \return ECS_RESULT_INVALID_STATE if the component type isn't stored in pools, or its pool
+          is owned by an EcsComponentGroup, which keeps its own order. Otherwise ECS_RESULT_SUCCESS.
+ */
+EcsResult ecs_component_sort(EcsWorld world, EcsComponentManager* manager, EcsComponentCompare compare);
+
+/*!
+  \brief Sorts the components of a component type on a world, assuming they're already mostly sorted.
+
+  Uses an insertion sort, so it's very fast when only a few components changed position since the last sort,
+  such as when sprites move a little between frames, but slow for data in a random order.
+  Otherwise behaves like ecs_component_sort.
+ */
+EcsResult ecs_component_sort_incremental(EcsWorld world, EcsComponentManager* manager, EcsComponentCompare compare);
+
+/*!
+  \brief Sorts the components of a component type on a world by a key computed once per component.
+
+  Uses a radix sort on the keys instead of comparing components. Use ecs_component_sort_key_int and
+  ecs_component_sort_key_float to turn signed values into keys that sort in the same order.
+  Otherwise behaves like ecs_component_sort.
+ */
+EcsResult ecs_component_sort_by_key(EcsWorld world, EcsComponentManager* manager, EcsComponentSortKey key);
+
+/// Converts a signed integer into a sort key that orders the same way.
+static inline uint32_t ecs_component_sort_key_int(int32_t value) {
+    return (uint32_t)value ^ 0x80000000u;
+}
+
+/// Converts a float into a sort key that orders the same way. NaNs are ordered first or last depending on their sign bit.
+static inline uint32_t ecs_component_sort_key_float(float value) {
+    uint32_t bits;
+    ecs_memcpy(&bits, &value, sizeof(bits));
+
+    // Negative floats are ordered backwards, so all of their bits are flipped, while positive floats only need the sign flipped.
+    return (bits & 0x80000000u) != 0 ? ~bits : bits | 0x80000000u;
+}
+
+/// \private
+/// Gets the index of the component associated with an entity, or -1 if the entity doesn't have the component.
+static inline int ecs_component_pool_lookup(EcsComponentPool* pool, int entity_id) {
+    int value = ecs_sparse_map_get(&pool->mapping, entity_id);
+    if(value == -1)
+        return -1;
+
+    return (value & 1) == 0 ? value >> 1 : pool->share_targets[value >> 1];
+}
+
+/// \private
+/// Gets the address of the component stored at the specified index of the pool.
+static inline char* ecs_component_pool_at(EcsComponentPool* pool, int index) {
+    if(pool->chunk_shift == 0)
+        return pool->components + (index * pool->component_size);
+
+    return pool->chunks[index >> pool->chunk_shift] + ((index & ((1 << pool->chunk_shift) - 1)) * pool->component_size);
+}
+
+/*!
+  \brief Gets the pool that stores a component type on a world, creating it if needed.
+
+  The pool stays valid until the world or the component type is freed, so it can be cached
+  and used with ecs_component_pool_get and ecs_component_pool_has to skip looking it up again.
+
+  \return The pool of the component type, or NULL if the component type isn't stored in pools.
+ */
+EcsComponentPool* ecs_component_get_pool(EcsWorld world, EcsComponentManager* manager);
+
+/// Gets the pool that stores a component type on a world, or NULL if it doesn't exist yet. Never allocates.
+static inline EcsComponentPool* ecs_component_find_pool(EcsWorld world, EcsComponentManager* manager) {
+    if(manager->storage != ECS_COMPONENT_STORAGE_POOL || (unsigned int)world >= (unsigned int)manager->pool_count)
+        return NULL;
+
+    return manager->pools[world];
+}
+
+/// Gets the component owned by an entity from a pool, or NULL if the entity doesn't own one.
+static inline void* ecs_component_pool_get(EcsComponentPool* pool, EcsEntity entity) {
+    int index = ecs_component_pool_lookup(pool, entity.id);
+    return index == -1 ? NULL : ecs_component_pool_at(pool, index);
+}
+
+/// Determines if an entity owns a component stored in a pool.
+static inline bool ecs_component_pool_has(EcsComponentPool* pool, EcsEntity entity) {
+    return ecs_sparse_map_get(&pool->mapping, entity.id) != -1;
+}
+
+/*!
+  \brief Gets a component owned by an entity without allocating anything.
+
+  Faster than ecs_component_get for pool storage because the lookup is inlined.
+
+  \return The component, or NULL if the entity doesn't own the component (or the component type is a tag).
+ */
+static inline void* ecs_component_try_get(EcsEntity entity, EcsComponentManager* manager) {
+    if(manager->storage == ECS_COMPONENT_STORAGE_POOL) {
+        EcsComponentPool* pool = ecs_component_find_pool(entity.world, manager);
+        return pool == NULL ? NULL : ecs_component_pool_get(pool, entity);
+    }
+
+    void* result = NULL;
+    ecs_component_get(entity, manager, &result);
+    return result;
+}
+
+/// Determines if an entity owns a component without allocating anything. An inlined version of ecs_component_exists.
+static inline bool ecs_component_has(EcsEntity entity, EcsComponentManager* manager) {
+    if(manager->storage == ECS_COMPONENT_STORAGE_POOL) {
+        EcsComponentPool* pool = ecs_component_find_pool(entity.world, manager);
+        return pool != NULL && ecs_component_pool_has(pool, entity);
+    }
+
+    return ecs_component_enum_get_flag(ecs_entity_get_components(entity), manager->flag);
+}
+
 /// Gets an EcsEventManager that is triggered when the specified component type is added to an entity.
 static inline EcsEventManager* ecs_component_get_added_event(EcsComponentManager* manager) {
     if(manager->added == NULL)
@@ -108,4 +474,20 @@ static inline EcsEventManager* ecs_component_get_removed_event(EcsComponentManag
     return manager->removed;
 }
 
+/// Gets an EcsEventManager that is triggered when the specified component type is added to multiple entities with ecs_component_set_many.
+static inline EcsEventManager* ecs_component_get_added_many_event(EcsComponentManager* manager) {
+    if(manager->added_many == NULL)
+        manager->added_many = ecs_event_define();
+
+    return manager->added_many;
+}
+
+/// Gets an EcsEventManager that is triggered when the specified component type is removed from multiple entities with ecs_component_remove_many.
+static inline EcsEventManager* ecs_component_get_removed_many_event(EcsComponentManager* manager) {
+    if(manager->removed_many == NULL)
+        manager->removed_many = ecs_event_define();
+
+    return manager->removed_many;
+}
+
 #endif
\ No newline at end of file
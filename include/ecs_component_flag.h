@@ -22,22 +22,25 @@ typedef long long ComponentFlag;
 #define COMPONENT_FLAG_BIT(f)   ((f) & COMPONENT_FLAG_BIT_MASK)
 
 /// \private
-extern ComponentFlag ___ecs_last_component_flag;
+/// Allocates the next unused ComponentFlag from the current EcsContext.
+ComponentFlag ecs_component_flag_get(void);
 
-/// \private
-static inline ComponentFlag ecs_component_flag_get() {
-    ComponentFlag flag = ___ecs_last_component_flag;
-    ___ecs_last_component_flag = (flag & COMPONENT_FLAG_BIT_MASK) != 0x80000000 ? ((flag & COMPONENT_FLAG_INDEX_MASK) | ((flag & COMPONENT_FLAG_BIT_MASK) << 1)) :
-                                                                                  ((flag & COMPONENT_FLAG_INDEX_MASK) + 0x100000000) + 1;
-
-    return flag;
-}
+#ifndef ECS_COMPONENT_ENUM_INLINE_WORDS
+/// The number of 32 bit words a ComponentEnum stores inline before moving its flags to the heap.
+/// The default of 4 allows 128 component types (including the alive and enabled flags) without any allocation.
+#define ECS_COMPONENT_ENUM_INLINE_WORDS 4
+#endif
 
 /// Contains a set of ComponentFlags.
 typedef struct ComponentEnum {
 /// \privatesection
-    unsigned int* bit_array;
+    // The number of words that can hold flags. If it's greater than ECS_COMPONENT_ENUM_INLINE_WORDS,
+    // the words are stored in bits.heap, otherwise they're stored in bits.words and any words past count are 0.
     int count;
+    union {
+        unsigned int words[ECS_COMPONENT_ENUM_INLINE_WORDS];
+        unsigned int* heap;
+    } bits;
 } ComponentEnum;
 
 /// The default ComponentEnum. Can be used as an r-value.
@@ -45,39 +48,78 @@ extern ComponentEnum COMPONENT_ENUM_DEFAULT;
 
 /// Initializes a ComponentEnum for use.
 static inline void ecs_component_enum_init(ComponentEnum* cenum) {
-    cenum->bit_array = NULL;
-    cenum->count = 0;
+    *cenum = COMPONENT_ENUM_DEFAULT;
+}
+
+/// \private
+/// Determines if the words of a ComponentEnum are stored on the heap.
+static inline bool ecs_component_enum_is_heap(const ComponentEnum* cenum) {
+    return cenum->count > ECS_COMPONENT_ENUM_INLINE_WORDS;
+}
+
+/// Gets the words that store the flags of a ComponentEnum. There are count words in the array.
+static inline unsigned int* ecs_component_enum_words(ComponentEnum* cenum) {
+    return ecs_component_enum_is_heap(cenum) ? cenum->bits.heap : cenum->bits.words;
 }
 
 /// Frees the resources held by a ComponentEnum. Does not free the ComponentEnum.
 static inline void ecs_component_enum_free_resources(ComponentEnum* cenum) {
-    if(cenum->bit_array != NULL)
-        ecs_free(cenum->bit_array);
+    if(ecs_component_enum_is_heap(cenum))
+        ecs_free(cenum->bits.heap);
 }
 
 /// Determines if a ComponentEnum has a specific ComponentFlag.
 static inline bool ecs_component_enum_get_flag(ComponentEnum* cenum, ComponentFlag flag) {
-    return COMPONENT_FLAG_INDEX(flag) < cenum->count && (cenum->bit_array[COMPONENT_FLAG_INDEX(flag)] & COMPONENT_FLAG_BIT(flag)) != 0;
+    return (int)COMPONENT_FLAG_INDEX(flag) < cenum->count && (ecs_component_enum_words(cenum)[COMPONENT_FLAG_INDEX(flag)] & COMPONENT_FLAG_BIT(flag)) != 0;
+}
+
+/// \private
+/// Moves the words of a ComponentEnum to the heap so that it can hold the word at the specified index.
+static inline void ecs_component_enum_grow(ComponentEnum* cenum, int index) {
+    int capacity = ECS_COMPONENT_ENUM_INLINE_WORDS * 2;
+    while(capacity <= index)
+        capacity *= 2;
+
+    unsigned int* heap = ecs_calloc(capacity, sizeof(unsigned int));
+    if(ecs_component_enum_is_heap(cenum)) {
+        ecs_memcpy(heap, cenum->bits.heap, cenum->count * sizeof(unsigned int));
+        ecs_free(cenum->bits.heap);
+    } else {
+        ecs_memcpy(heap, cenum->bits.words, sizeof(cenum->bits.words));
+    }
+
+    cenum->bits.heap = heap;
+    cenum->count = capacity;
 }
 
 /// Sets a ComponentFlag in a ComponentEnum to the specified value.
 static inline void ecs_component_enum_set_flag(ComponentEnum* cenum, ComponentFlag flag, bool value) {
     int index = COMPONENT_FLAG_INDEX(flag);
-    ECS_ARRAY_RESIZE_DEFAULT(cenum->bit_array, cenum->count, index + 1, sizeof(unsigned int), 0);
+    if(index >= cenum->count) {
+        if(!value)
+            return;
+
+        if(index < ECS_COMPONENT_ENUM_INLINE_WORDS)
+            cenum->count = index + 1;
+        else
+            ecs_component_enum_grow(cenum, index);
+    }
+
+    unsigned int* words = ecs_component_enum_words(cenum);
     if(value)
-        cenum->bit_array[index] |= COMPONENT_FLAG_BIT(flag);
+        words[index] |= COMPONENT_FLAG_BIT(flag);
     else
-        cenum->bit_array[index] &= ~COMPONENT_FLAG_BIT(flag);
+        words[index] &= ~COMPONENT_FLAG_BIT(flag);
 }
 
 /// Determines if a ComponentEnum is a superset of another ComponentEnum.
 static inline bool ecs_component_enum_contains_enum(ComponentEnum* cenum, ComponentEnum* filter) {
-    if(filter->count != 0) {
-        for(int i = 0; i < filter->count; ++i) {
-            unsigned int part = filter->bit_array[i];
-            if(part != 0 && (i >= cenum->count || (cenum->bit_array[i] & part) != part))
-                return false;
-        }
+    unsigned int* words = ecs_component_enum_words(cenum);
+    unsigned int* filter_words = ecs_component_enum_words(filter);
+    for(int i = 0; i < filter->count; ++i) {
+        unsigned int part = filter_words[i];
+        if(part != 0 && (i >= cenum->count || (words[i] & part) != part))
+            return false;
     }
 
     return true;
@@ -85,29 +127,76 @@ static inline bool ecs_component_enum_contains_enum(ComponentEnum* cenum, Compon
 
 /// Determines if a ComponentEnum does not intersect at all with another ComponentEnum.
 static inline bool ecs_component_enum_not_contains_enum(ComponentEnum* cenum, ComponentEnum* filter) {
-    if(filter->count != 0) {
-        for(int i = 0; i < filter->count; ++i) {
-            unsigned int part = filter->bit_array[i];
-            if(part != 0 && i < cenum->count && (cenum->bit_array[i] & part) != 0u)
-                return false;
-        }
+    unsigned int* words = ecs_component_enum_words(cenum);
+    unsigned int* filter_words = ecs_component_enum_words(filter);
+    int count = filter->count < cenum->count ? filter->count : cenum->count;
+    for(int i = 0; i < count; ++i) {
+        if((words[i] & filter_words[i]) != 0u)
+            return false;
     }
 
     return true;
 }
 
+/// Determines if two ComponentEnums have exactly the same flags set.
+static inline bool ecs_component_enum_equals(ComponentEnum* left, ComponentEnum* right) {
+    unsigned int* left_words = ecs_component_enum_words(left);
+    unsigned int* right_words = ecs_component_enum_words(right);
+    int count = left->count > right->count ? left->count : right->count;
+    for(int i = 0; i < count; ++i) {
+        unsigned int left_part = i < left->count ? left_words[i] : 0u;
+        unsigned int right_part = i < right->count ? right_words[i] : 0u;
+        if(left_part != right_part)
+            return false;
+    }
+
+    return true;
+}
+
+/// Hashes the flags of a ComponentEnum. ComponentEnums that are equal always have the same hash.
+static inline unsigned int ecs_component_enum_hash(ComponentEnum* cenum) {
+    unsigned int* words = ecs_component_enum_words(cenum);
+    unsigned int hash = 2166136261u;
+    for(int i = 0; i < cenum->count; ++i) {
+        // Empty words are skipped so that the number of words doesn't change the hash.
+        if(words[i] != 0u)
+            hash = (hash ^ (words[i] + (unsigned int)i * 0x9e3779b9u)) * 16777619u;
+    }
+
+    return hash;
+}
+
+/*!
+  \brief Matches an array of ComponentEnums against a with and without filter at once.
+
+  Signatures whose flags are stored inline are compared without any branches, using SSE2 or AVX2
+  when the compiler targets them and a scalar loop otherwise. Signatures stored on the heap
+  fall back to ecs_component_enum_contains_enum and ecs_component_enum_not_contains_enum.
+
+  \param signatures The ComponentEnums to match.
+  \param count The number of ComponentEnums in the signatures array.
+  \param with The flags a signature must contain.
+  \param without The flags a signature can't contain.
+  \param mask An array of at least (count + 63) / 64 words. Bit (i % 64) of word (i / 64) is set
+              if signatures[i] matches the filter, otherwise it's cleared.
+  \return The number of signatures that matched.
+ */
+int ecs_component_enum_match_many(ComponentEnum* signatures, int count, ComponentEnum* with, ComponentEnum* without, uint64_t* mask);
+
 /// Creates a new ComponentEnum and copies the values from another ComponentEnum.
 static inline ComponentEnum ecs_component_enum_copy(ComponentEnum* src) {
-    ComponentEnum result;
-    result.bit_array = ecs_malloc(src->count * sizeof(unsigned int));
-    ecs_memcpy(result.bit_array, src->bit_array, src->count * sizeof(unsigned int));
-    result.count = src->count;
+    ComponentEnum result = *src;
+    if(ecs_component_enum_is_heap(src)) {
+        result.bits.heap = ecs_malloc(src->count * sizeof(unsigned int));
+        ecs_memcpy(result.bits.heap, src->bits.heap, src->count * sizeof(unsigned int));
+    }
+
     return result;
 }
 
 /// Clears the information stored by a ComponentEnum.
 static inline void ecs_component_enum_clear(ComponentEnum* cenum) {
-    ecs_memset(cenum->bit_array, 0, cenum->count);
+    ecs_memset(ecs_component_enum_words(cenum), 0, cenum->count * sizeof(unsigned int));
 }
 
 #endif
\ No newline at end of file
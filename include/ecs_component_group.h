@@ -0,0 +1,79 @@
+/*!
+ * @file
+ *
+ * \brief Keeps the components of entities that own several component types packed in the same order.
+ *
+ * The components in an EcsComponentPool are stored in the order they were added, so iterating over
+ * the entities that own two component types jumps around both pools. An EcsComponentGroup owns the pools
+ * of a set of component types on a world, and keeps each of them partitioned so that the entities
+ * that own every one of the component types occupy the indices [0, size) of each pool, in the same order.
+ * A system can then walk the component arrays side by side without looking anything up.
+ *
+ * Adding and removing owned components costs a few extra swaps to keep the partition up to date.
+ * Those swaps move the components of other entities in every owned pool, not only in the pool of the
+ * component type that was added or removed. Any pointer returned by ecs_component_set or ecs_component_get
+ * for an owned component type is invalidated when an owned component type is added to or removed from
+ * any entity, so look the components up again afterwards.
+ * A pool can only be owned by one group, and the components of an owned pool can't be shared
+ * with ecs_component_set_same_as. Whether an entity is enabled doesn't affect the group.
+ */
+#ifndef ECS_COMPONENT_GROUP_H
+#define ECS_COMPONENT_GROUP_H
+
+#include "ecs_common.h"
+#include "ecs_entity.h"
+#include "ecs_component.h"
+
+/// Keeps the entities that own every one of a set of component types at the front of their pools.
+typedef struct EcsComponentGroup EcsComponentGroup;
+
+/*!
+    \brief Creates a group that owns the pools of the specified component types on a world.
+
+    The entities that already own every component type are moved to the front of the pools.
+
+    \param world The world of the pools.
+    \param managers The component types to own. They must be stored in contiguous pools, so they can't be
+                    archetype components, tags, or chunked component types.
+    \param count The number of component types in managers.
+    \return The new group, or NULL if one of the component types can't be owned, one of the pools is already
+            owned by another group, or one of the pools has shared components.
+ */
+EcsComponentGroup* ecs_component_group_init(EcsWorld world, EcsComponentManager** managers, int count);
+
+/// Frees an EcsComponentGroup. The pools keep their current order, but are no longer kept partitioned.
+void ecs_component_group_free(EcsComponentGroup* group);
+
+/// Gets the number of entities that own every component type of the group. Returns 0 once one of the pools was freed.
+int ecs_component_group_size(EcsComponentGroup* group);
+
+/*!
+    \brief Gets the components of one of the owned component types.
+
+    The component at index i belongs to the same entity in the array of each owned component type,
+    and to the entity returned by ecs_component_group_get_entity for i.
+    The array is invalidated when any of the owned component types are added to or removed from an entity.
+
+    \param group The group to get the components from.
+    \param manager One of the component types owned by the group.
+    \param count A pointer that is filled with the number of components in the group.
+    \return The components of the group, or NULL if the component type isn't owned by the group.
+ */
+void* ecs_component_group_get_components(EcsComponentGroup* group, EcsComponentManager* manager, int* count);
+
+/// Gets the entity at the specified index of the group. The id of the entity is -1 once one of the pools was freed.
+EcsEntity ecs_component_group_get_entity(EcsComponentGroup* group, int index);
+
+/// \private
+/// Called by a pool when a component was added to an entity, so the entity can join the group.
+void ecs_component_group_on_add(EcsComponentGroup* group, int entity_id);
+
+/// \private
+/// Called by a pool before a component is removed from an entity, so the entity can leave the group.
+void ecs_component_group_on_remove(EcsComponentGroup* group, int entity_id);
+
+/// \private
+/// Called when one of the owned pools is freed. The group stops tracking all of its pools.
+void ecs_component_group_detach(EcsComponentGroup* group);
+
+#endif
\ No newline at end of file
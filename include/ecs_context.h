@@ -0,0 +1,78 @@
+/*!
+ * @file
+ *
+ * \brief Owns the state shared by every world, so independent sets of worlds can run on separate threads.
+ *
+ * The world table, the component flag allocator, and the built in event managers all live in an EcsContext.
+ * ecs_init sets up a default context that is used by any thread that hasn't selected one. A thread that calls
+ * ecs_context_set_current uses its own context instead, and can create worlds, define component types,
+ * and update systems without touching the state of any other context, so no locks are needed.
+ *
+ * Component types, event managers, and entity sets belong to the context that was current when they
+ * were created, and should only be used while that context is current.
+ */
+#ifndef ECS_CONTEXT_H
+#define ECS_CONTEXT_H
+
+#include "ecs_common.h"
+#include "ecs_component_flag.h"
+#include "ecs_event.h"
+
+/// Holds all of the state that used to be global, so that each thread can drive its own worlds.
+typedef struct EcsContext EcsContext;
+
+struct EcsContext {
+/// \privatesection
+    ComponentFlag last_component_flag;
+    ComponentFlag is_alive_flag;
+    ComponentFlag is_enabled_flag;
+
+    EcsEvent* world_disposed;
+    EcsEventManager* entity_created;
+    EcsEventManager* entity_disposed;
+    EcsEventManager* entity_enabled;
+    EcsEventManager* entity_disabled;
+
+    // Owned by ecs_world.c, ecs_archetype.c, and ecs_entity_set.c respectively.
+    struct EcsWorldManager* worlds;
+    struct EcsArchetypeStorage** archetype_storages;
+    int archetype_storage_capacity;
+    struct EcsEntitySetRegistry** entity_set_registries;
+    int entity_set_registry_capacity;
+};
+
+/// \private
+extern EcsContext ___ecs_default_context;
+
+/// \private
+extern ECS_THREAD_LOCAL EcsContext* ___ecs_current_context;
+
+/// Gets the context used by the calling thread.
+static inline EcsContext* ecs_context_get_current(void) {
+    EcsContext* context = ___ecs_current_context;
+    return context != NULL ? context : &___ecs_default_context;
+}
+
+/*!
+    \brief Makes a context the current context of the calling thread.
+
+    \param context The context to use. Can be NULL to go back to the default context.
+ */
+void ecs_context_set_current(EcsContext* context);
+
+/// Creates a new context that doesn't share any state with the other contexts. ecs_init must be called first.
+EcsContext* ecs_context_init(void);
+
+/*!
+    \brief Frees a context created by ecs_context_init.
+
+    The worlds, component types, and event managers created with the context should be freed first.
+
+    \param context The context to free. Must not be current on any other thread.
+ */
+void ecs_context_free(EcsContext* context);
+
+/// Initializes the state of a context. Should not be called directly.
+void ecs_context_setup(EcsContext* context);
+
+#endif
\ No newline at end of file
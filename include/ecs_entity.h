@@ -1,6 +1,8 @@
 #ifndef ECS_ENTITY_H
 #define ECS_ENTITY_H
 
+#include <stdint.h>
+
 /// A world that can create entities, components, and systems.
 typedef int EcsWorld;
 
@@ -13,4 +15,59 @@ typedef struct EcsEntity {
     int id;
 } EcsEntity;
 
+/*!
+    \brief A packed reference to an entity that can detect when the entity has been freed.
+
+    Entity ids are reused after an entity is freed, so an EcsEntity that is kept around can end up
+    referring to a different entity. A handle also stores the generation of the entity's slot,
+    which changes every time an entity in that slot is freed. This makes handles safe to cache
+    inside of components (e.g. targets or parents) and check with ecs_handle_is_alive.
+
+    The bits are laid out as world:index:generation, from the most significant to the least.
+ */
+typedef uint64_t EcsHandle;
+
+/// The number of bits used to store the world of an EcsHandle. Entities of worlds with larger ids can't have handles.
+#define ECS_HANDLE_WORLD_BITS 12
+
+/// The number of bits used to store the entity id of an EcsHandle.
+#define ECS_HANDLE_INDEX_BITS 32
+
+/// The number of bits used to store the generation of an EcsHandle. Generations wrap around after this many bits.
+#define ECS_HANDLE_GENERATION_BITS 20
+
+/// The mask applied to a generation before it's stored in an EcsHandle.
+#define ECS_HANDLE_GENERATION_MASK ((1u << ECS_HANDLE_GENERATION_BITS) - 1)
+
+/// A handle that never refers to a live entity.
+#define ECS_HANDLE_NULL ((EcsHandle)0)
+
+/// \private
+static inline EcsHandle ecs_handle_pack(int world, int id, unsigned int generation) {
+    return ((uint64_t)(unsigned int)world << (ECS_HANDLE_INDEX_BITS + ECS_HANDLE_GENERATION_BITS))
+         | ((uint64_t)(unsigned int)id << ECS_HANDLE_GENERATION_BITS)
+         | (generation & ECS_HANDLE_GENERATION_MASK);
+}
+
+/// Gets the world of the entity referred to by a handle.
+static inline EcsWorld ecs_handle_get_world(EcsHandle handle) {
+    return (EcsWorld)(handle >> (ECS_HANDLE_INDEX_BITS + ECS_HANDLE_GENERATION_BITS));
+}
+
+/// Gets the id of the entity referred to by a handle.
+static inline int ecs_handle_get_id(EcsHandle handle) {
+    return (int)(uint32_t)(handle >> ECS_HANDLE_GENERATION_BITS);
+}
+
+/// Gets the generation stored in a handle.
+static inline unsigned int ecs_handle_get_generation(EcsHandle handle) {
+    return (unsigned int)(handle & ECS_HANDLE_GENERATION_MASK);
+}
+
+/// Converts a handle back into an EcsEntity without checking if the entity is still alive.
+static inline EcsEntity ecs_handle_get_entity(EcsHandle handle) {
+    EcsEntity entity = { ecs_handle_get_world(handle), ecs_handle_get_id(handle) };
+    return entity;
+}
+
 #endif
\ No newline at end of file
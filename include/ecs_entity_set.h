@@ -6,6 +6,15 @@
  * This header defines a data structure that can be used to get all entities with and without specific components.
  * It's primarily used by EcsEntitySystem, but it can be used directly for more performance, or for
  * specific operations where you need all of the entities at once.
+ *
+ * The sets of a world are indexed by the component types they use, and each component type is only
+ * subscribed to once per world no matter how many sets use it. When a component is added or removed,
+ * only the sets that use that component type are checked.
+ *
+ * Sets are not thread safe. ecs_entity_set_get_entities brings the set up to date and records statistics,
+ * so it writes to the set even though it looks like a read. Because sets with the same constraints are shared,
+ * two owners that built their sets separately can still be holding the same set, and must not get its
+ * entities at the same time. An EcsSchedulerSystem never runs two entity systems with the same set at once.
  */
 #ifndef ECS_ENTITY_SET_H
 #define ECS_ENTITY_SET_H
@@ -20,6 +29,45 @@ typedef struct EcsEntitySetBuilder EcsEntitySetBuilder;
 /// Keeps an updated set of entities with and without specific components.
 typedef struct EcsEntitySet EcsEntitySet;
 
+/// Determines how an EcsEntitySet keeps track of the entities that satisfy its conditions.
+typedef enum EcsEntitySetMode {
+    /// The set is updated by component events as soon as an entity changes. Cheap to iterate, but every change costs a little.
+    ECS_ENTITY_SET_MODE_MAINTAINED,
+
+    /// The events only mark the set as changed, and the set is rebuilt by scanning the signature of every entity
+    /// in the world the next time the entities are requested. Faster when the components change every frame.
+    ECS_ENTITY_SET_MODE_SCAN
+} EcsEntitySetMode;
+
+#ifndef ECS_ENTITY_SET_CHANGE_COST
+/// The estimated cost of handling a single change in ECS_ENTITY_SET_MODE_MAINTAINED,
+/// measured in the number of entity signatures that can be scanned in the same time.
+#define ECS_ENTITY_SET_CHANGE_COST 32
+#endif
+
+#ifndef ECS_ENTITY_SET_ADAPT_FRAMES
+/// The number of frames in a row the other mode has to be cheaper before an adaptive set switches to it.
+#define ECS_ENTITY_SET_ADAPT_FRAMES 8
+#endif
+
+/// Statistics about how an EcsEntitySet was updated, for profiling which mode a set should be in.
+typedef struct EcsEntitySetStats {
+    /// The mode the set is currently in.
+    EcsEntitySetMode mode;
+
+    /// Determines if the set switches modes on its own.
+    bool adaptive;
+
+    /// The number of changes the set was notified about during the current frame, up to the last call to ecs_entity_set_get_entities.
+    int changes;
+
+    /// The number of entity signatures scanned by the last call to ecs_entity_set_get_entities.
+    int scanned;
+
+    /// The number of times the set has switched modes.
+    int switches;
+} EcsEntitySetStats;
+
 /// Initializes a new EcsEntitySetBuilder.
 EcsEntitySetBuilder* ecs_entity_set_builder_init(void);
 
@@ -35,22 +83,89 @@ void ecs_entity_set_without(EcsEntitySetBuilder* builder, EcsComponentManager* m
 /*!
     \brief Builds an EcsEntitySet using the constraints set on EcsEntitySetBuilder.
 
+    If the world already has a set with the same constraints, that set is returned instead of building a new one.
+    Shared sets are reference counted, so each call must still be matched by a call to ecs_entity_set_free.
+    Changing the mode of a shared set changes it for every owner. Adaptive sets expect every owner to call
+    ecs_entity_set_get_entities once per frame, and only count a frame once all of them did.
+
     \param builder The builder used to make the set.
     \param world The world to get the entities from.
     \param free_builder true if the function should free the builder, false otherwise.
 */
 EcsEntitySet* ecs_entity_set_build(EcsEntitySetBuilder* builder, EcsWorld world, bool free_builder);
 
-/// Frees an EcsEntitySet.
+/// Frees an EcsEntitySet. Shared sets are only freed once every owner has freed them.
 void ecs_entity_set_free(EcsEntitySet* set);
 
 /*!
     \brief Gets an array of entities that satisfy the EcsEntitySet conditions.
 
+    Each call counts as a frame for adaptive sets, or for a shared set, one call of every owner does.
+    The number of changes during the frame is compared to the number of entities in the world, and the set
+    switches to whichever mode would have been cheaper once that mode has been cheaper for
+    ECS_ENTITY_SET_ADAPT_FRAMES frames in a row.
+    The order of the entities can change when the set switches modes.
+
     \param set The EcsEntitySet to get the entities from.
     \param count A pointer that is filled with the length of the entity array.
     \return An array of entities that satisfy the entity set.
  */
 EcsEntity* ecs_entity_set_get_entities(EcsEntitySet* set, int* count);
 
+/*!
+    \brief Changes how an EcsEntitySet is updated.
+
+    Sets start in ECS_ENTITY_SET_MODE_MAINTAINED and are adaptive.
+
+    \param set The set to modify.
+    \param mode The mode to switch to.
+    \param adaptive true if the set should keep switching modes on its own based on how much it changes, false to keep the mode.
+ */
+void ecs_entity_set_set_mode(EcsEntitySet* set, EcsEntitySetMode mode, bool adaptive);
+
+/// Gets statistics about how an EcsEntitySet has been updated.
+EcsEntitySetStats ecs_entity_set_get_stats(EcsEntitySet* set);
+
+/// A function that is called for each entity of an EcsEntitySet by ecs_entity_set_each.
+/// components holds one pointer per component type that was requested, in the same order.
+typedef void (*EcsEntitySetEachFunction)(void* data, EcsEntity entity, void** components);
+
+/// A function that is called for each batch of entities of an EcsEntitySet by ecs_entity_set_each_batch.
+/// The pointer to component type c of entities[i] is stored at components[c * count + i].
+typedef void (*EcsEntitySetEachBatchFunction)(void* data, EcsEntity* entities, void** components, int count);
+
+/*!
+    \brief Calls a function for each entity of an EcsEntitySet along with its components.
+
+    The pools of the component types are looked up once per call rather than once per entity,
+    so this is faster than calling ecs_component_get for each component of each entity.
+    The set's entities are retrieved using ecs_entity_set_get_entities.
+    Entities and components must not be added or removed by the function.
+
+    \param set The set to iterate over.
+    \param managers The component types to get. The pointer is NULL for tags and for component types the entity doesn't own.
+    \param manager_count The number of component types in managers.
+    \param fn The function to call for each entity.
+    \param data A value passed to each call of fn.
+ */
+void ecs_entity_set_each(EcsEntitySet* set, EcsComponentManager** managers, int manager_count, EcsEntitySetEachFunction fn, void* data);
+
+/*!
+    \brief Calls a function for batches of entities of an EcsEntitySet along with their components.
+
+    \param set The set to iterate over.
+    \param managers The component types to get. The pointer is NULL for tags and for component types the entity doesn't own.
+    \param manager_count The number of component types in managers.
+    \param batch_size The maximum number of entities passed to each call of fn. If it's less than 1, every entity is passed at once.
+    \param fn The function to call for each batch.
+    \param data A value passed to each call of fn.
+ */
+void ecs_entity_set_each_batch(EcsEntitySet* set, EcsComponentManager** managers, int manager_count, int batch_size, EcsEntitySetEachBatchFunction fn, void* data);
+
+/// Initializes the entity set registry of the current context. Should not be called directly.
+void ecs_entity_set_system_init(void);
+
+/// Frees the entity set registry of the current context. Should not be called directly.
+void ecs_entity_set_system_free(void);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,67 @@
+/*!
+ * @file
+ *
+ * \brief A pool of worker threads that splits loops into chunks and runs them across cores.
+ *
+ * ecs_job_pool_parallel_for divides a range into chunks of grain_size items and hands each participating
+ * thread (the workers and the calling thread) a contiguous share of the chunks. A thread that finishes its
+ * own share steals the remaining chunks of the other threads, so uneven work still keeps every core busy.
+ * The call returns once every chunk has been processed.
+ *
+ * Workers run with the EcsContext of the thread that started the loop, so the job function can read
+ * components of the worlds it's iterating. Structural changes (creating or freeing entities, adding or
+ * removing components) are not thread safe and should be recorded into one EcsCommandBuffer per worker,
+ * selected using ecs_job_get_worker_index, then played back after the loop.
+ */
+#ifndef ECS_JOB_H
+#define ECS_JOB_H
+
+#include "ecs_common.h"
+
+/// A pool of worker threads.
+typedef struct EcsJobPool EcsJobPool;
+
+/*!
+    \brief A function that processes a range of items of a parallel loop.
+
+    \param data The data passed to ecs_job_pool_parallel_for.
+    \param start The index of the first item to process.
+    \param end The index after the last item to process.
+ */
+typedef void (*EcsJobFunction)(void* data, int start, int end);
+
+/*!
+    \brief Creates a pool of worker threads.
+
+    \param thread_count The number of worker threads to start. If 0 or less, one thread is started for each
+                        core except the one used by the calling thread.
+    \return A new EcsJobPool, or NULL if the threads couldn't be started.
+ */
+EcsJobPool* ecs_job_pool_init(int thread_count);
+
+/// Stops the worker threads of a pool, then frees the pool.
+void ecs_job_pool_free(EcsJobPool* pool);
+
+/// Gets the number of worker threads in a pool, not including the thread that calls ecs_job_pool_parallel_for.
+int ecs_job_pool_get_thread_count(EcsJobPool* pool);
+
+/*!
+    \brief Calls a function over a range of items using every thread of a pool, and waits for it to finish.
+
+    The calling thread takes part in the loop. Only one loop can run on a pool at a time.
+    A loop started from inside of a job of the same pool runs entirely on the thread that started it.
+
+    \param pool The pool to run the loop on. If NULL, the loop runs on the calling thread.
+    \param count The number of items in the range.
+    \param grain_size The number of items each call to the function processes. If 0 or less, the range is divided
+                      into roughly 8 chunks per thread.
+    \param function The function that processes each chunk.
+    \param data A value passed to the function.
+ */
+void ecs_job_pool_parallel_for(EcsJobPool* pool, int count, int grain_size, EcsJobFunction function, void* data);
+
+/// Gets the index of the calling thread inside of the loop it's running. The thread that started the loop
+/// (or any thread that isn't a worker) is 0, and the workers are numbered from 1 to the thread count.
+int ecs_job_get_worker_index(void);
+
+#endif
\ No newline at end of file
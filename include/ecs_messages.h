@@ -7,6 +7,7 @@
 #include "ecs_common.h"
 #include "ecs_entity.h"
 #include "ecs_event.h"
+#include "ecs_context.h"
 
 /// Message sent when an EcsEntity is created.
 typedef struct EcsEntityCreatedMessage {
@@ -61,29 +62,58 @@ typedef struct EcsComponentRemovedMessage {
     void* component;
 } EcsComponentRemovedMessage;
 
+/// Message sent when a component is added to multiple entities at once using ecs_component_set_many.
+/// The entities may include disabled entities.
+typedef struct EcsComponentAddedManyMessage {
+    /// The entities that had the component added to them.
+    EcsEntity* entities;
+
+    /// The number of entities in the array.
+    int count;
+
+    /// The type of the component added to the entities.
+    EcsComponentManager* component_type;
+} EcsComponentAddedManyMessage;
+
+/// Message sent when a component is removed from multiple entities at once using ecs_component_remove_many.
+/// The entities may include disabled entities.
+typedef struct EcsComponentRemovedManyMessage {
+    /// The entities that had the component removed from them.
+    EcsEntity* entities;
+
+    /// The number of entities in the array.
+    int count;
+
+    /// The type of the component that was removed.
+    EcsComponentManager* component_type;
+} EcsComponentRemovedManyMessage;
+
 /// Message sent when a world is freed.
 typedef struct EcsWorldDisposedMessage {
     /// The world that was freed.
     EcsWorld world;
 } EcsWorldDisposedMessage;
 
-/// Event manager that is triggered when an entity is created.
-extern EcsEventManager* ecs_entity_created;
+/// Event manager that is triggered when an entity is created. Belongs to the current EcsContext.
+#define ecs_entity_created (ecs_context_get_current()->entity_created)
 
-/// Event manager that is triggered when an entity is freed.
-extern EcsEventManager* ecs_entity_disposed;
+/// Event manager that is triggered when an entity is freed. Belongs to the current EcsContext.
+#define ecs_entity_disposed (ecs_context_get_current()->entity_disposed)
 
-/// Event manager that is triggered when an entity is enabled.
-extern EcsEventManager* ecs_entity_enabled;
+/// Event manager that is triggered when an entity is enabled. Belongs to the current EcsContext.
+#define ecs_entity_enabled (ecs_context_get_current()->entity_enabled)
 
-/// Event manager that is triggered when an entity is disabled.
-extern EcsEventManager* ecs_entity_disabled;
+/// Event manager that is triggered when an entity is disabled. Belongs to the current EcsContext.
+#define ecs_entity_disabled (ecs_context_get_current()->entity_disabled)
 
-/// An event that is triggered when a world is freed.
-extern EcsEvent* ecs_world_disposed;
+/// An event that is triggered when a world is freed. Belongs to the current EcsContext.
+#define ecs_world_disposed (ecs_context_get_current()->world_disposed)
 
 /// Initializes the various events that utilize the messages. Should not be called directly.
 void ecs_messages_init(void);
 
+/// Frees the events created by ecs_messages_init. Should not be called directly.
+void ecs_messages_free(void);
+
 
 #endif
\ No newline at end of file
@@ -0,0 +1,135 @@
+/*!
+ * @file
+ *
+ * \brief A paged map from non-negative ids to non-negative ints.
+ *
+ * This header defines a utility struct that maps ids (typically entity ids)
+ * to indexes of a dense array. The map is split into fixed-size pages that are only
+ * allocated once an id inside of the page is set, so the memory used scales
+ * with the number of ids stored instead of the largest id. Lookups are still O(1).
+ *
+ * Each page counts the ids stored in it. The most recently emptied page is kept around, so that an id
+ * that keeps being set and removed on an otherwise empty page doesn't allocate the page every time.
+ * It's only freed once another page becomes empty. The array of page pointers is halved once
+ * the allocated pages only use a quarter of it.
+ */
+#ifndef ECS_SPARSE_MAP_H
+#define ECS_SPARSE_MAP_H
+
+#include "ecs_common.h"
+
+#ifndef ECS_SPARSE_PAGE_SHIFT
+/// The log2 of the number of ids stored by each page of an EcsSparseMap.
+#define ECS_SPARSE_PAGE_SHIFT 10
+#endif
+
+/// The number of ids stored by each page of an EcsSparseMap.
+#define ECS_SPARSE_PAGE_SIZE (1 << ECS_SPARSE_PAGE_SHIFT)
+
+/// \private
+/// A zeroed page shared by every map for pages that haven't been allocated. Never written to.
+extern int ___ecs_sparse_null_page[ECS_SPARSE_PAGE_SIZE];
+
+/// Maps ids to ints using lazily allocated pages.
+typedef struct EcsSparseMap {
+/// \privatesection
+    // Values are stored offset by one so that a zeroed page represents an empty page.
+    // Allocated pages hold one extra int past the values with the number of ids in the page.
+    int** pages;
+    int page_count;
+
+    // One past the highest allocated page.
+    int page_end;
+
+    // The page that was emptied last and hasn't been freed yet, or -1.
+    int empty_page;
+} EcsSparseMap;
+
+/// Initializes an EcsSparseMap for use.
+static inline void ecs_sparse_map_init(EcsSparseMap* map) {
+    map->pages = NULL;
+    map->page_count = 0;
+    map->page_end = 0;
+    map->empty_page = -1;
+}
+
+/// Frees the resources held by an EcsSparseMap. Does not free the map.
+static inline void ecs_sparse_map_free_resources(EcsSparseMap* map) {
+    if(map->pages == NULL)
+        return;
+
+    for(int i = 0; i < map->page_count; ++i) {
+        if(map->pages[i] != ___ecs_sparse_null_page)
+            ecs_free(map->pages[i]);
+    }
+
+    ecs_free(map->pages);
+}
+
+/// Gets the value associated with an id, or -1 if the id isn't in the map.
+static inline int ecs_sparse_map_get(EcsSparseMap* map, int id) {
+    unsigned int page = (unsigned int)id >> ECS_SPARSE_PAGE_SHIFT;
+    if(page >= (unsigned int)map->page_count)
+        return -1;
+
+    return map->pages[page][id & (ECS_SPARSE_PAGE_SIZE - 1)] - 1;
+}
+
+/// Associates a non-negative value with an id, allocating the page of the id if needed.
+static inline void ecs_sparse_map_set(EcsSparseMap* map, int id, int value) {
+    int page = id >> ECS_SPARSE_PAGE_SHIFT;
+    ECS_ARRAY_RESIZE_DEFAULT(map->pages, map->page_count, page, sizeof(int*), ___ecs_sparse_null_page);
+
+    if(map->pages[page] == ___ecs_sparse_null_page) {
+        map->pages[page] = ecs_calloc(ECS_SPARSE_PAGE_SIZE + 1, sizeof(int));
+        if(page >= map->page_end)
+            map->page_end = page + 1;
+    }
+
+    int* values = map->pages[page];
+    if(values[id & (ECS_SPARSE_PAGE_SIZE - 1)] == 0) {
+        // The kept empty page is in use again, so it can't be freed when another page becomes empty.
+        if(values[ECS_SPARSE_PAGE_SIZE]++ == 0 && page == map->empty_page)
+            map->empty_page = -1;
+    }
+
+    values[id & (ECS_SPARSE_PAGE_SIZE - 1)] = value + 1;
+}
+
+/// \private
+/// Keeps a page that just became empty, freeing the page that was kept before it.
+void ecs_sparse_map_release_page(EcsSparseMap* map, int page);
+
+/// Removes an id from the map.
+static inline void ecs_sparse_map_remove(EcsSparseMap* map, int id) {
+    unsigned int page = (unsigned int)id >> ECS_SPARSE_PAGE_SHIFT;
+    if(page >= (unsigned int)map->page_count)
+        return;
+
+    int* values = map->pages[page];
+    if(values == ___ecs_sparse_null_page || values[id & (ECS_SPARSE_PAGE_SIZE - 1)] == 0)
+        return;
+
+    values[id & (ECS_SPARSE_PAGE_SIZE - 1)] = 0;
+    if(--values[ECS_SPARSE_PAGE_SIZE] == 0)
+        ecs_sparse_map_release_page(map, (int)page);
+}
+
+/// Gets the first id that is greater than or equal to the specified id and is in the map, or -1 if there is none.
+/// Pages that were never allocated are skipped entirely.
+static inline int ecs_sparse_map_next(EcsSparseMap* map, int id) {
+    for(int page = id >> ECS_SPARSE_PAGE_SHIFT; page < map->page_count; ++page, id = page << ECS_SPARSE_PAGE_SHIFT) {
+        int* values = map->pages[page];
+        if(values == ___ecs_sparse_null_page)
+            continue;
+
+        for(int i = id & (ECS_SPARSE_PAGE_SIZE - 1); i < ECS_SPARSE_PAGE_SIZE; ++i) {
+            if(values[i] != 0)
+                return (page << ECS_SPARSE_PAGE_SHIFT) | i;
+        }
+    }
+
+    return -1;
+}
+
+#endif
@@ -7,6 +7,7 @@
 #include "ecs_component.h"
 #include "ecs_entity.h"
 #include "ecs_entity_set.h"
+#include "ecs_job.h"
 
 /// The base type of an Ecs System.
 typedef struct EcsSystem EcsSystem;
@@ -23,6 +24,9 @@ typedef struct EcsActionSystem EcsActionSystem;
 /// A system that updates any number of subsystems on update.
 typedef struct EcsSequentialSystem EcsSequentialSystem;
 
+/// A system that runs its subsystems concurrently when they don't access the same components.
+typedef struct EcsSchedulerSystem EcsSchedulerSystem;
+
 /// A function that is called before a system update.
 typedef void (*EcsSystemPreupdate)(EcsSystem*, float);
 
@@ -35,6 +39,12 @@ typedef void (*EcsSystemUpdateComponent)(EcsComponentSystem*, float, void*);
 /// A function that is called when an EcsEntitySystem updates.
 typedef void (*EcsSystemUpdateEcsEntity)(EcsEntitySystem*, float, EcsEntity);
 
+/// A function that is called when an EcsComponentSystem updates with a contiguous run of count components starting at first.
+typedef void (*EcsSystemUpdateComponentBatch)(EcsComponentSystem*, float, void* first, int count);
+
+/// A function that is called when an EcsEntitySystem updates with a contiguous run of count entities.
+typedef void (*EcsSystemUpdateEcsEntityBatch)(EcsEntitySystem*, float, EcsEntity* entities, int count);
+
 /// A function that is called when an EcsActionSystem updates.
 typedef void (*EcsSystemUpdateAction)(EcsActionSystem*, float);
 
@@ -50,7 +60,10 @@ typedef enum EcsSystemType {
     ECS_SYSTEM_TYPE_SEQUENTIAL,
 
     /// An EcsActionSystem
-    ECS_SYSTEM_TYPE_ACTION
+    ECS_SYSTEM_TYPE_ACTION,
+
+    /// An EcsSchedulerSystem
+    ECS_SYSTEM_TYPE_SCHEDULER
 } EcsSystemType;
 
 struct EcsSystem {
@@ -67,7 +80,16 @@ struct EcsComponentSystem {
     EcsSystem base;
     EcsComponentManager* manager;
     EcsSystemUpdateComponent update;
+    EcsSystemUpdateComponentBatch update_batch;
     EcsWorld world;
+
+    // The world tick of the last update, used when only changed components are visited.
+    unsigned int last_tick;
+    bool changed_only;
+
+    // If not NULL, the update is split into chunks of grain_size components that run on this pool.
+    EcsJobPool* jobs;
+    int grain_size;
 };
 
 struct EcsEntitySystem {
@@ -75,7 +97,16 @@ struct EcsEntitySystem {
     EcsSystem base;
     EcsEntitySet* entities;
     EcsSystemUpdateEcsEntity update;
+    EcsSystemUpdateEcsEntityBatch update_batch;
     EcsWorld world;
+
+    // If not NULL, only entities whose component of this type changed since last_tick are visited.
+    EcsComponentManager* changed;
+    unsigned int last_tick;
+
+    // If not NULL, the update is split into chunks of grain_size entities that run on this pool.
+    EcsJobPool* jobs;
+    int grain_size;
 };
 
 struct EcsActionSystem {
@@ -92,6 +123,37 @@ struct EcsSequentialSystem {
     bool free_children;
 };
 
+/// \private
+/// A subsystem of an EcsSchedulerSystem along with the components it accesses.
+typedef struct EcsScheduledSystem {
+    EcsSystem* system;
+    EcsComponentManager** reads;
+    int read_count;
+    EcsComponentManager** writes;
+    int write_count;
+    bool exclusive;
+
+    // The number of systems that have to run before this one along the longest chain of conflicts.
+    int level;
+} EcsScheduledSystem;
+
+struct EcsSchedulerSystem {
+/// \privatesection
+    EcsSystem base;
+    EcsJobPool* jobs;
+    EcsScheduledSystem* systems;
+    int count;
+    int capacity;
+
+    // The indices of the systems sorted by level, and the index into order where each level starts.
+    // levels has level_count + 1 elements so that the end of the last level can be read the same way.
+    int* order;
+    int* levels;
+    int level_count;
+    bool dirty;
+    bool free_children;
+};
+
 /// Initializes an EcsSystem. Should not be called directly.
 void ecs_system_init(EcsSystem* system, EcsSystemType type, EcsSystemPreupdate preupdate, EcsSystemPostupdate postupdate);
 
@@ -125,6 +187,27 @@ void ecs_component_system_init(EcsComponentSystem* system,
                                EcsSystemPreupdate preupdate, 
                                EcsSystemPostupdate postupdate);
 
+/*!
+    \brief Initializes a component system that updates contiguous runs of components at once.
+
+    Instead of calling a function for every component, update_batch is called once for every run of components
+    that are next to each other in memory, which lets the function use SIMD and hoist work out of its loop.
+    The components of a run are component_size bytes apart (including any padding added by ecs_component_define_aligned).
+
+    \param system The component system to initialize.
+    \param world The to get the components from.
+    \param component_type The type of the component to get.
+    \param update_batch The function to call for each run of components. Can be NULL.
+    \param preupdate The function to call before each update. Can be NULL.
+    \param postupdate The function to call after each update. Can be NULL.
+ */
+void ecs_component_system_init_batch(EcsComponentSystem* system,
+                                     EcsWorld world,
+                                     EcsComponentManager* component_type,
+                                     EcsSystemUpdateComponentBatch update_batch,
+                                     EcsSystemPreupdate preupdate,
+                                     EcsSystemPostupdate postupdate);
+
 /*!
     \brief Initializes an entity system.
 
@@ -144,6 +227,76 @@ void ecs_entity_system_init(EcsEntitySystem* system,
                             EcsSystemPreupdate preupdate, 
                             EcsSystemPostupdate postupdate);
 
+/*!
+    \brief Initializes an entity system that updates runs of entities at once.
+
+    update_batch is called with spans of the entity set instead of one entity at a time.
+    The span must not be modified, and the set must not change while the function is running.
+
+    \param system The entity system to initialize.
+    \param world The world to get the entities from.
+    \param builder The builder that defines the components required of the entity to be processed during the system update.
+    \param free_builder Determines if the function frees the builder when it's finished using it.
+    \param update_batch The function to call for each span of entities. Can be NULL.
+    \param preupdate The function to call before each update. Can be NULL.
+    \param postupdate The function to call after each update. Can be NULL.
+ */
+void ecs_entity_system_init_batch(EcsEntitySystem* system,
+                                  EcsWorld world,
+                                  EcsEntitySetBuilder* builder,
+                                  bool free_builder,
+                                  EcsSystemUpdateEcsEntityBatch update_batch,
+                                  EcsSystemPreupdate preupdate,
+                                  EcsSystemPostupdate postupdate);
+
+/*!
+    \brief Makes a component system only visit components that changed since its last update.
+
+    The first update visits every component. After each update, the tick of the system's world is advanced
+    so that components written after the update are visited by the next one.
+
+    \param system The component system to modify.
+    \return ECS_RESULT_SUCCESS, or ECS_RESULT_INVALID_STATE if the component type doesn't track changes.
+ */
+EcsResult ecs_component_system_track_changes(EcsComponentSystem* system);
+
+/*!
+    \brief Makes an entity system only visit entities whose component changed since its last update.
+
+    The first update visits every entity in the set. After each update, the tick of the system's world is advanced
+    so that components written after the update are visited by the next one.
+
+    \param system The entity system to modify.
+    \param component_type The component type to check for changes. Must track changes.
+    \return ECS_RESULT_SUCCESS, or ECS_RESULT_INVALID_STATE if the component type doesn't track changes.
+ */
+EcsResult ecs_entity_system_track_changes(EcsEntitySystem* system, EcsComponentManager* component_type);
+
+/*!
+    \brief Makes a component system split its updates across the threads of a job pool.
+
+    The update function is called from several threads at once, so it must only modify the component it's given.
+    Every call finishes before the postupdate function is called.
+
+    \param system The component system to modify.
+    \param pool The pool to run the updates on, or NULL to run them on the calling thread.
+    \param grain_size The number of components each job processes. If 0 or less, it's picked based on the number of threads.
+ */
+void ecs_component_system_set_parallel(EcsComponentSystem* system, EcsJobPool* pool, int grain_size);
+
+/*!
+    \brief Makes an entity system split its updates across the threads of a job pool.
+
+    The update function is called from several threads at once, so it must only modify the components of the entity it's given,
+    and structural changes must be recorded into a separate EcsCommandBuffer for each worker (see ecs_job_get_worker_index).
+    Every call finishes before the postupdate function is called.
+
+    \param system The entity system to modify.
+    \param pool The pool to run the updates on, or NULL to run them on the calling thread.
+    \param grain_size The number of entities each job processes. If 0 or less, it's picked based on the number of threads.
+ */
+void ecs_entity_system_set_parallel(EcsEntitySystem* system, EcsJobPool* pool, int grain_size);
+
 /*!
     \brief Initializes an action system.
 
@@ -212,6 +365,53 @@ void ecs_sequential_system_init_list(EcsSequentialSystem* system,
                                      int count,
                                      va_list list);
 
+/*!
+    \brief Initializes a scheduler system.
+
+    Subsystems are added using ecs_scheduler_system_add. Two subsystems conflict if one of them writes a component type
+    that the other one reads or writes, if both are entity systems with the same (shared) EcsEntitySet,
+    or if either of them is exclusive. Conflicting subsystems run in the order they
+    were added, while every other subsystem can run at the same time on the threads of the job pool.
+
+    \param system The scheduler system to initialize.
+    \param pool The pool to run the subsystems on. Can be NULL to run them one after another on the calling thread.
+    \param preupdate The function to call before each update. Can be NULL.
+    \param postupdate The function to call after each update. Can be NULL.
+    \param free_children Determines if the subsystems are freed with their resources when the scheduler system is freed.
+ */
+void ecs_scheduler_system_init(EcsSchedulerSystem* system,
+                               EcsJobPool* pool,
+                               EcsSystemPreupdate preupdate,
+                               EcsSystemPostupdate postupdate,
+                               bool free_children);
+
+/*!
+    \brief Adds a subsystem to a scheduler system.
+
+    The subsystem must only access the component types it declares. Creating or freeing entities,
+    adding or removing components, and advancing the tick of a world aren't thread safe, so subsystems
+    that do any of those should be added using ecs_scheduler_system_add_exclusive instead.
+    Component and entity systems that only visit changed components advance the tick of their world,
+    so they are always added as exclusive. Track changes on them before they're added to the scheduler.
+
+    \param scheduler The scheduler system to add the subsystem to.
+    \param system The subsystem to add.
+    \param reads The component types the subsystem reads. The values are copied. Can be NULL if read_count is 0.
+    \param read_count The number of component types in reads.
+    \param writes The component types the subsystem writes. The values are copied. Can be NULL if write_count is 0.
+    \param write_count The number of component types in writes.
+ */
+void ecs_scheduler_system_add(EcsSchedulerSystem* scheduler,
+                              EcsSystem* system,
+                              EcsComponentManager** reads,
+                              int read_count,
+                              EcsComponentManager** writes,
+                              int write_count);
+
+/// Adds a subsystem to a scheduler system that conflicts with every other subsystem,
+/// so it never runs at the same time as any of them.
+void ecs_scheduler_system_add_exclusive(EcsSchedulerSystem* scheduler, EcsSystem* system);
+
 /*!
     \brief Updates a system.
 
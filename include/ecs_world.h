@@ -6,16 +6,26 @@
 #include "ecs_common.h"
 #include "ecs_component_flag.h"
 #include "ecs_event.h"
+#include "ecs_context.h"
 
 /// Initializes the world subsystem. Should not be called directly.
 void ecs_world_system_init(void);
 
+/// Frees the world subsystem of the current context. Should not be called directly.
+void ecs_world_system_free(void);
+
 /// Creates a new EcsWorld.
 EcsWorld ecs_world_init(void);
 
 /// Frees all entities, components, and events associated with an EcsWorld, then frees the world.
 EcsResult ecs_world_free(EcsWorld world);
 
+/// Gets the current change tick of a world. Components written with change tracking enabled store this tick as their version.
+unsigned int ecs_world_get_tick(EcsWorld world);
+
+/// Advances the change tick of a world and returns the new tick. Systems that only visit changed components call this after they run.
+unsigned int ecs_world_advance_tick(EcsWorld world);
+
 /// Creates an entity in the given world.
 EcsEntity ecs_create_entity(EcsWorld world);
 
@@ -34,6 +44,34 @@ bool ecs_entity_is_alive(EcsEntity entity);
 /// Determines if an entity is alive and enabled.
 bool ecs_entity_is_enabled(EcsEntity entity);
 
+/// Gets the generation of an entity's slot. The generation changes every time an entity in the slot is freed.
+unsigned int ecs_entity_get_generation(EcsEntity entity);
+
+/// Creates a handle that refers to an entity until it's freed. Returns ECS_HANDLE_NULL if the entity isn't alive,
+/// or if the id of its world doesn't fit in ECS_HANDLE_WORLD_BITS.
+EcsHandle ecs_entity_get_handle(EcsEntity entity);
+
+/*!
+    \brief Determines if the entity referred to by a handle is still alive.
+
+    This only compares the generation stored in the handle against the generation of the entity's slot,
+    so it's much cheaper than validating an EcsEntity that might have been freed and reused.
+    Handles to the entities of a world that has been freed are never alive, even if the world id is reused.
+
+    \param handle The handle to check.
+    \return true if the entity hasn't been freed since the handle was created.
+ */
+bool ecs_handle_is_alive(EcsHandle handle);
+
+/*!
+    \brief Converts a handle into the entity it refers to if the entity is still alive.
+
+    \param handle The handle to convert.
+    \param entity A pointer filled with the entity if it's alive.
+    \return true if the entity is alive, false otherwise.
+ */
+bool ecs_handle_get_alive_entity(EcsHandle handle, EcsEntity* entity);
+
 /// Gets all component types associated with an entity.
 ComponentEnum* ecs_entity_get_components(EcsEntity entity);
 
@@ -47,9 +85,9 @@ ComponentEnum* ecs_entity_get_components(EcsEntity entity);
 ComponentEnum* ecs_world_get_components(EcsWorld world, int* count);
 
 /// A flag that determines if an entity is alive.
-extern ComponentFlag ecs_is_alive_flag;
+#define ecs_is_alive_flag (ecs_context_get_current()->is_alive_flag)
 
 /// A flag that determines if an entity is enabled.
-extern ComponentFlag ecs_is_enabled_flag;
+#define ecs_is_enabled_flag (ecs_context_get_current()->is_enabled_flag)
 
 #endif
\ No newline at end of file
@@ -1,6 +1,5 @@
 #include "ecs.h"
 
 void ecs_init(void) {
-    ecs_messages_init();
-    ecs_world_system_init();
+    ecs_context_setup(&___ecs_default_context);
 }
\ No newline at end of file
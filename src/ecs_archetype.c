@@ -0,0 +1,528 @@
+#include "ecs_archetype.h"
+
+#include "ecs_event.h"
+#include "ecs_messages.h"
+#include "ecs_sparse_map.h"
+#include "ecs_world.h"
+
+// A cached transition from one archetype to another when a component is added or removed.
+typedef struct ArchetypeEdge {
+    ComponentFlag flag;
+    int add;
+    int remove;
+} ArchetypeEdge;
+
+// A table of entities that own the same set of archetype components.
+typedef struct EcsArchetype {
+    ComponentEnum signature;
+    EcsComponentManager** managers;
+    char** columns;
+    int column_count;
+    EcsEntity* entities;
+    int count;
+    int capacity;
+    ArchetypeEdge* edges;
+    int edge_count;
+    int edge_capacity;
+} EcsArchetype;
+
+// The archetypes of a single world. The archetype at index 0 is the empty archetype.
+// It never stores any entities, it's only used as the starting point of transitions.
+typedef struct EcsArchetypeStorage {
+    EcsArchetype** archetypes;
+    int archetype_count;
+    int archetype_capacity;
+
+    // Maps an entity id to the index of its archetype and its row in that archetype.
+    EcsSparseMap tables;
+    EcsSparseMap rows;
+} EcsArchetypeStorage;
+
+struct EcsArchetypeQuery {
+    EcsWorld world;
+    ComponentEnum with;
+    ComponentEnum without;
+    EcsComponentManager** with_components;
+    int with_count;
+
+    // The matching archetypes, and for each of them the column of every with component.
+    int* tables;
+    int* table_columns;
+    int table_count;
+    int table_capacity;
+    int column_capacity;
+
+    // The number of archetypes that have already been matched against the query.
+    int checked;
+
+    void** current_columns;
+};
+
+static int ecs_archetype_column_of(EcsArchetype* archetype, EcsComponentManager* manager) {
+    for(int i = 0; i < archetype->column_count; ++i) {
+        if(archetype->managers[i] == manager)
+            return i;
+    }
+
+    return -1;
+}
+
+static bool ecs_archetype_signature_equals(ComponentEnum* left, ComponentEnum* right) {
+    unsigned int* left_words = ecs_component_enum_words(left);
+    unsigned int* right_words = ecs_component_enum_words(right);
+    int count = left->count > right->count ? left->count : right->count;
+    for(int i = 0; i < count; ++i) {
+        unsigned int l = i < left->count ? left_words[i] : 0;
+        unsigned int r = i < right->count ? right_words[i] : 0;
+        if(l != r)
+            return false;
+    }
+
+    return true;
+}
+
+static EcsArchetype* ecs_archetype_init(ComponentEnum signature, EcsComponentManager** managers, int column_count) {
+    EcsArchetype* archetype = ecs_malloc(sizeof(EcsArchetype));
+    archetype->signature = signature;
+    archetype->managers = managers;
+    archetype->columns = column_count == 0 ? NULL : ecs_malloc(sizeof(char*) * column_count);
+    for(int i = 0; i < column_count; ++i)
+        archetype->columns[i] = NULL;
+    archetype->column_count = column_count;
+    archetype->entities = NULL;
+    archetype->count = 0;
+    archetype->capacity = 0;
+    archetype->edges = NULL;
+    archetype->edge_count = 0;
+    archetype->edge_capacity = 0;
+    return archetype;
+}
+
+static void ecs_archetype_free(EcsArchetype* archetype) {
+    for(int i = 0; i < archetype->column_count; ++i) {
+        EcsComponentDestructor destructor = archetype->managers[i]->destructor;
+        if(destructor != NULL) {
+            for(int row = 0; row < archetype->count; ++row)
+                destructor(archetype->columns[i] + row * archetype->managers[i]->component_size);
+        }
+
+        ecs_aligned_free(archetype->columns[i], archetype->managers[i]->alignment);
+    }
+
+    ecs_free(archetype->columns);
+    ecs_free(archetype->managers);
+    ecs_free(archetype->entities);
+    ecs_free(archetype->edges);
+    ecs_component_enum_free_resources(&archetype->signature);
+    ecs_free(archetype);
+}
+
+static void ecs_archetype_storage_free(EcsArchetypeStorage* storage) {
+    for(int i = 0; i < storage->archetype_count; ++i)
+        ecs_archetype_free(storage->archetypes[i]);
+
+    ecs_free(storage->archetypes);
+    ecs_sparse_map_free_resources(&storage->tables);
+    ecs_sparse_map_free_resources(&storage->rows);
+    ecs_free(storage);
+}
+
+static void archetype_on_world_disposed(void* data, EcsWorldDisposedMessage* message) {
+    EcsContext* context = data;
+    if(message->world < context->archetype_storage_capacity && context->archetype_storages[message->world] != NULL) {
+        ecs_archetype_storage_free(context->archetype_storages[message->world]);
+        context->archetype_storages[message->world] = NULL;
+    }
+}
+
+void ecs_archetype_system_init(void) {
+    EcsContext* context = ecs_context_get_current();
+    context->archetype_storages = NULL;
+    context->archetype_storage_capacity = 0;
+    ecs_event_add(ecs_world_disposed, ecs_closure(context, archetype_on_world_disposed));
+}
+
+void ecs_archetype_system_free(void) {
+    EcsContext* context = ecs_context_get_current();
+    for(int i = 0; i < context->archetype_storage_capacity; ++i) {
+        if(context->archetype_storages[i] != NULL)
+            ecs_archetype_storage_free(context->archetype_storages[i]);
+    }
+
+    ecs_free(context->archetype_storages);
+    context->archetype_storages = NULL;
+    context->archetype_storage_capacity = 0;
+}
+
+static EcsArchetypeStorage* ecs_archetype_storage_get(EcsWorld world) {
+    EcsContext* context = ecs_context_get_current();
+    if(world >= context->archetype_storage_capacity)
+        return NULL;
+
+    return context->archetype_storages[world];
+}
+
+static EcsArchetypeStorage* ecs_archetype_storage_get_or_create(EcsWorld world) {
+    EcsContext* context = ecs_context_get_current();
+    if(world < context->archetype_storage_capacity && context->archetype_storages[world] != NULL)
+        return context->archetype_storages[world];
+
+    ECS_ARRAY_RESIZE_DEFAULT(context->archetype_storages, context->archetype_storage_capacity, world, sizeof(EcsArchetypeStorage*), NULL);
+
+    EcsArchetypeStorage* storage = ecs_malloc(sizeof(EcsArchetypeStorage));
+    storage->archetypes = NULL;
+    storage->archetype_count = 0;
+    storage->archetype_capacity = 0;
+    ecs_sparse_map_init(&storage->tables);
+    ecs_sparse_map_init(&storage->rows);
+
+    ECS_ARRAY_RESIZE(storage->archetypes, storage->archetype_capacity, 0, sizeof(*storage->archetypes));
+    storage->archetypes[storage->archetype_count++] = ecs_archetype_init(COMPONENT_ENUM_DEFAULT, NULL, 0);
+
+    context->archetype_storages[world] = storage;
+    return storage;
+}
+
+// Gets the archetype that results from adding or removing a component from another archetype.
+// The result is cached on the source archetype, so only the first transition has to search the archetypes.
+static int ecs_archetype_transition(EcsArchetypeStorage* storage, int from, EcsComponentManager* manager, bool add) {
+    EcsArchetype* source = storage->archetypes[from];
+    ArchetypeEdge* edge = NULL;
+    for(int i = 0; i < source->edge_count; ++i) {
+        if(source->edges[i].flag == manager->flag) {
+            edge = source->edges + i;
+            break;
+        }
+    }
+
+    if(edge != NULL && (add ? edge->add : edge->remove) != -1)
+        return add ? edge->add : edge->remove;
+
+    ComponentEnum signature = ecs_component_enum_copy(&source->signature);
+    ecs_component_enum_set_flag(&signature, manager->flag, add);
+
+    int result = -1;
+    for(int i = 0; i < storage->archetype_count; ++i) {
+        if(ecs_archetype_signature_equals(&storage->archetypes[i]->signature, &signature)) {
+            result = i;
+            break;
+        }
+    }
+
+    if(result == -1) {
+        int column_count = source->column_count + (add ? 1 : -1);
+        EcsComponentManager** managers = column_count == 0 ? NULL : ecs_malloc(sizeof(EcsComponentManager*) * column_count);
+        int column = 0;
+        for(int i = 0; i < source->column_count; ++i) {
+            if(source->managers[i] != manager)
+                managers[column++] = source->managers[i];
+        }
+
+        if(add)
+            managers[column] = manager;
+
+        ECS_ARRAY_RESIZE(storage->archetypes, storage->archetype_capacity, storage->archetype_count, sizeof(*storage->archetypes));
+        result = storage->archetype_count++;
+        storage->archetypes[result] = ecs_archetype_init(signature, managers, column_count);
+    } else {
+        ecs_component_enum_free_resources(&signature);
+    }
+
+    if(edge == NULL) {
+        ECS_ARRAY_RESIZE(source->edges, source->edge_capacity, source->edge_count, sizeof(*source->edges));
+        edge = source->edges + source->edge_count++;
+        edge->flag = manager->flag;
+        edge->add = -1;
+        edge->remove = -1;
+    }
+
+    if(add)
+        edge->add = result;
+    else
+        edge->remove = result;
+
+    return result;
+}
+
+static void ecs_archetype_reserve(EcsArchetype* archetype, int row) {
+    if(row < archetype->capacity)
+        return;
+
+    int capacity = archetype->capacity == 0 ? 4 : archetype->capacity;
+    while(capacity <= row)
+        capacity *= 2;
+
+    for(int i = 0; i < archetype->column_count; ++i) {
+        EcsComponentManager* manager = archetype->managers[i];
+        archetype->columns[i] = ecs_aligned_realloc(archetype->columns[i],
+                                                    (size_t)manager->component_size * archetype->capacity,
+                                                    (size_t)manager->component_size * capacity,
+                                                    manager->alignment);
+    }
+
+    archetype->entities = ecs_realloc(archetype->entities, sizeof(EcsEntity) * capacity);
+    archetype->capacity = capacity;
+}
+
+// Removes a row from an archetype by moving the last row into its place.
+static void ecs_archetype_remove_row(EcsArchetypeStorage* storage, EcsArchetype* archetype, int row) {
+    int last = --archetype->count;
+    if(row == last)
+        return;
+
+    for(int i = 0; i < archetype->column_count; ++i) {
+        int size = archetype->managers[i]->component_size;
+        ecs_memcpy(archetype->columns[i] + row * size, archetype->columns[i] + last * size, size);
+    }
+
+    archetype->entities[row] = archetype->entities[last];
+    ecs_sparse_map_set(&storage->rows, archetype->entities[row].id, row);
+}
+
+// Moves an entity from one archetype to another, copying every component the archetypes have in common.
+// Components that only exist in the target archetype are left uninitialized.
+static void ecs_archetype_move(EcsArchetypeStorage* storage, EcsEntity entity, int from, int to) {
+    EcsArchetype* source = storage->archetypes[from];
+    EcsArchetype* target = storage->archetypes[to];
+    int row = from == 0 ? -1 : ecs_sparse_map_get(&storage->rows, entity.id);
+
+    if(to != 0) {
+        int new_row = target->count++;
+        ecs_archetype_reserve(target, new_row);
+        target->entities[new_row] = entity;
+
+        if(row != -1) {
+            for(int i = 0; i < target->column_count; ++i) {
+                int column = ecs_archetype_column_of(source, target->managers[i]);
+                if(column == -1)
+                    continue;
+
+                int size = target->managers[i]->component_size;
+                ecs_memcpy(target->columns[i] + new_row * size, source->columns[column] + row * size, size);
+            }
+        }
+
+        ecs_sparse_map_set(&storage->tables, entity.id, to);
+        ecs_sparse_map_set(&storage->rows, entity.id, new_row);
+    } else {
+        ecs_sparse_map_remove(&storage->tables, entity.id);
+        ecs_sparse_map_remove(&storage->rows, entity.id);
+    }
+
+    if(row != -1)
+        ecs_archetype_remove_row(storage, source, row);
+}
+
+void* ecs_archetype_set(EcsEntity entity, EcsComponentManager* manager, bool* added) {
+    EcsArchetypeStorage* storage = ecs_archetype_storage_get_or_create(entity.world);
+
+    int from = ecs_sparse_map_get(&storage->tables, entity.id);
+    if(from == -1)
+        from = 0;
+
+    EcsArchetype* archetype = storage->archetypes[from];
+    int column = ecs_archetype_column_of(archetype, manager);
+    if(column != -1) {
+        *added = false;
+        return archetype->columns[column] + ecs_sparse_map_get(&storage->rows, entity.id) * manager->component_size;
+    }
+
+    int to = ecs_archetype_transition(storage, from, manager, true);
+    ecs_archetype_move(storage, entity, from, to);
+
+    *added = true;
+    archetype = storage->archetypes[to];
+    column = ecs_archetype_column_of(archetype, manager);
+    return archetype->columns[column] + ecs_sparse_map_get(&storage->rows, entity.id) * manager->component_size;
+}
+
+bool ecs_archetype_remove(EcsEntity entity, EcsComponentManager* manager) {
+    EcsArchetypeStorage* storage = ecs_archetype_storage_get(entity.world);
+    if(storage == NULL)
+        return false;
+
+    int from = ecs_sparse_map_get(&storage->tables, entity.id);
+    if(from == -1 || ecs_archetype_column_of(storage->archetypes[from], manager) == -1)
+        return false;
+
+    int to = ecs_archetype_transition(storage, from, manager, false);
+    ecs_archetype_move(storage, entity, from, to);
+    return true;
+}
+
+void* ecs_archetype_get(EcsEntity entity, EcsComponentManager* manager) {
+    EcsArchetypeStorage* storage = ecs_archetype_storage_get(entity.world);
+    if(storage == NULL)
+        return NULL;
+
+    int table = ecs_sparse_map_get(&storage->tables, entity.id);
+    if(table == -1)
+        return NULL;
+
+    EcsArchetype* archetype = storage->archetypes[table];
+    int column = ecs_archetype_column_of(archetype, manager);
+    if(column == -1)
+        return NULL;
+
+    return archetype->columns[column] + ecs_sparse_map_get(&storage->rows, entity.id) * manager->component_size;
+}
+
+void* ecs_archetype_get_column(EcsWorld world, EcsComponentManager* manager, int column, int* count) {
+    EcsArchetypeStorage* storage = ecs_archetype_storage_get(world);
+    *count = 0;
+    if(storage == NULL || column < 0)
+        return NULL;
+
+    for(int i = 1; i < storage->archetype_count; ++i) {
+        EcsArchetype* archetype = storage->archetypes[i];
+        if(archetype->count == 0)
+            continue;
+
+        int index = ecs_archetype_column_of(archetype, manager);
+        if(index == -1)
+            continue;
+
+        if(column-- == 0) {
+            *count = archetype->count;
+            return archetype->columns[index];
+        }
+    }
+
+    return NULL;
+}
+
+void ecs_archetype_clear(EcsWorld world, EcsComponentManager* manager) {
+    EcsArchetypeStorage* storage = ecs_archetype_storage_get(world);
+    if(storage == NULL)
+        return;
+
+    int entity_count;
+    ComponentEnum* components = ecs_world_get_components(world, &entity_count);
+
+    for(int i = 1; i < storage->archetype_count; ++i) {
+        EcsArchetype* archetype = storage->archetypes[i];
+        int column = ecs_archetype_column_of(archetype, manager);
+        if(column == -1)
+            continue;
+
+        // Moving an entity removes it from this archetype, so always take the last one.
+        while(archetype->count > 0) {
+            EcsEntity entity = archetype->entities[archetype->count - 1];
+            if(manager->destructor != NULL)
+                manager->destructor(archetype->columns[column] + (archetype->count - 1) * manager->component_size);
+
+            ecs_component_enum_set_flag(components + entity.id, manager->flag, false);
+            ecs_archetype_move(storage, entity, i, ecs_archetype_transition(storage, i, manager, false));
+        }
+    }
+}
+
+EcsArchetypeQuery* ecs_archetype_query_init(EcsWorld world,
+                                            EcsComponentManager** with,
+                                            int with_count,
+                                            EcsComponentManager** without,
+                                            int without_count)
+{
+    for(int i = 0; i < with_count; ++i) {
+        if(with[i]->storage != ECS_COMPONENT_STORAGE_ARCHETYPE)
+            return NULL;
+    }
+
+    // Tables only know their archetype components, so any other without component couldn't be filtered out.
+    for(int i = 0; i < without_count; ++i) {
+        if(without[i]->storage != ECS_COMPONENT_STORAGE_ARCHETYPE)
+            return NULL;
+    }
+
+    EcsArchetypeQuery* query = ecs_malloc(sizeof(EcsArchetypeQuery));
+    query->world = world;
+    query->with = COMPONENT_ENUM_DEFAULT;
+    query->without = COMPONENT_ENUM_DEFAULT;
+    query->with_count = with_count;
+    query->with_components = ecs_malloc(sizeof(EcsComponentManager*) * (with_count == 0 ? 1 : with_count));
+    ecs_memcpy(query->with_components, with, sizeof(EcsComponentManager*) * with_count);
+    query->current_columns = ecs_malloc(sizeof(void*) * (with_count == 0 ? 1 : with_count));
+    query->tables = NULL;
+    query->table_columns = NULL;
+    query->table_count = 0;
+    query->table_capacity = 0;
+    query->column_capacity = 0;
+    query->checked = 0;
+
+    for(int i = 0; i < with_count; ++i)
+        ecs_component_enum_set_flag(&query->with, with[i]->flag, true);
+
+    for(int i = 0; i < without_count; ++i)
+        ecs_component_enum_set_flag(&query->without, without[i]->flag, true);
+
+    return query;
+}
+
+void ecs_archetype_query_free(EcsArchetypeQuery* query) {
+    ecs_component_enum_free_resources(&query->with);
+    ecs_component_enum_free_resources(&query->without);
+    ecs_free(query->with_components);
+    ecs_free(query->current_columns);
+    ecs_free(query->tables);
+    ecs_free(query->table_columns);
+    ecs_free(query);
+}
+
+void ecs_archetype_query_iter(EcsArchetypeQuery* query, EcsArchetypeIterator* iterator) {
+    EcsArchetypeStorage* storage = ecs_archetype_storage_get(query->world);
+
+    iterator->query = query;
+    iterator->table = -1;
+    iterator->entities = NULL;
+    iterator->columns = query->current_columns;
+    iterator->count = 0;
+
+    if(storage == NULL)
+        return;
+
+    // Match any archetypes that were created since the last iteration. The empty archetype is never matched.
+    for(int i = query->checked > 1 ? query->checked : 1; i < storage->archetype_count; ++i) {
+        EcsArchetype* archetype = storage->archetypes[i];
+        if(!ecs_component_enum_contains_enum(&archetype->signature, &query->with) ||
+           !ecs_component_enum_not_contains_enum(&archetype->signature, &query->without))
+        {
+            continue;
+        }
+
+        ECS_ARRAY_RESIZE(query->tables, query->table_capacity, query->table_count, sizeof(int));
+        ECS_ARRAY_RESIZE(query->table_columns,
+                         query->column_capacity,
+                         (query->table_count + 1) * query->with_count,
+                         sizeof(int));
+
+        for(int j = 0; j < query->with_count; ++j)
+            query->table_columns[query->table_count * query->with_count + j] = ecs_archetype_column_of(archetype, query->with_components[j]);
+
+        query->tables[query->table_count++] = i;
+    }
+
+    query->checked = storage->archetype_count;
+}
+
+bool ecs_archetype_iter_next(EcsArchetypeIterator* iterator) {
+    EcsArchetypeQuery* query = iterator->query;
+    EcsArchetypeStorage* storage = ecs_archetype_storage_get(query->world);
+    if(storage == NULL)
+        return false;
+
+    while(++iterator->table < query->table_count) {
+        EcsArchetype* archetype = storage->archetypes[query->tables[iterator->table]];
+        if(archetype->count == 0)
+            continue;
+
+        int* columns = query->table_columns + iterator->table * query->with_count;
+        for(int i = 0; i < query->with_count; ++i)
+            iterator->columns[i] = archetype->columns[columns[i]];
+
+        iterator->entities = archetype->entities;
+        iterator->count = archetype->count;
+        return true;
+    }
+
+    return false;
+}
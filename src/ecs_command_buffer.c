@@ -0,0 +1,249 @@
+#include "ecs_command_buffer.h"
+
+#include "ecs_world.h"
+
+typedef enum EcsCommandType {
+    ECS_COMMAND_CREATE,
+    ECS_COMMAND_FREE,
+    ECS_COMMAND_SET,
+    ECS_COMMAND_REMOVE,
+    ECS_COMMAND_ENABLE,
+    ECS_COMMAND_DISABLE
+} EcsCommandType;
+
+typedef struct EcsCommand {
+    EcsCommandType type;
+    EcsEntity entity;
+    EcsComponentManager* manager;
+
+    // The offset of the component value in the data arena, or -1 if there is no value.
+    int data;
+
+    // The order the command was recorded in. Used to keep the order of the commands of an entity after sorting.
+    int sequence;
+    bool skip;
+} EcsCommand;
+
+struct EcsCommandBuffer {
+    EcsWorld world;
+
+    EcsCommand* commands;
+    int command_count;
+    int command_capacity;
+
+    // The number of create commands that are waiting to be played back.
+    int placeholder_count;
+
+    // Component values are copied back to back into a single arena instead of being allocated one by one.
+    char* data;
+    int data_count;
+    int data_capacity;
+
+    // The entities created by the last playback, indexed by placeholder.
+    EcsEntity* created;
+    int create_count;
+    int created_capacity;
+};
+
+// Placeholders use negative ids so they can't be confused with real entities.
+#define ECS_COMMAND_PLACEHOLDER(index) (-1 - (index))
+#define ECS_COMMAND_PLACEHOLDER_INDEX(id) (-1 - (id))
+
+EcsCommandBuffer* ecs_command_buffer_init(EcsWorld world) {
+    EcsCommandBuffer* buffer = ecs_malloc(sizeof(EcsCommandBuffer));
+    buffer->world = world;
+    buffer->commands = NULL;
+    buffer->command_count = 0;
+    buffer->command_capacity = 0;
+    buffer->placeholder_count = 0;
+    buffer->data = NULL;
+    buffer->data_count = 0;
+    buffer->data_capacity = 0;
+    buffer->created = NULL;
+    buffer->create_count = 0;
+    buffer->created_capacity = 0;
+    return buffer;
+}
+
+// Destroys the component value recorded by a set command that won't be applied.
+static void ecs_command_buffer_discard(EcsCommandBuffer* buffer, EcsCommand* command) {
+    if(command->type == ECS_COMMAND_SET && command->data != -1 && command->manager->destructor != NULL)
+        command->manager->destructor(buffer->data + command->data);
+}
+
+void ecs_command_buffer_free(EcsCommandBuffer* buffer) {
+    for(int i = 0; i < buffer->command_count; ++i)
+        ecs_command_buffer_discard(buffer, buffer->commands + i);
+
+    ecs_free(buffer->commands);
+    ecs_free(buffer->data);
+    ecs_free(buffer->created);
+    ecs_free(buffer);
+}
+
+static EcsCommand* ecs_command_buffer_push(EcsCommandBuffer* buffer, EcsCommandType type, EcsEntity entity, EcsComponentManager* manager) {
+    ECS_ARRAY_RESIZE(buffer->commands, buffer->command_capacity, buffer->command_count, sizeof(EcsCommand));
+
+    EcsCommand* command = buffer->commands + buffer->command_count;
+    command->type = type;
+    command->entity = entity;
+    command->manager = manager;
+    command->data = -1;
+    command->sequence = buffer->command_count++;
+    command->skip = false;
+    return command;
+}
+
+EcsEntity ecs_command_buffer_create_entity(EcsCommandBuffer* buffer) {
+    EcsEntity entity = { buffer->world, ECS_COMMAND_PLACEHOLDER(buffer->placeholder_count++) };
+    ecs_command_buffer_push(buffer, ECS_COMMAND_CREATE, entity, NULL);
+    return entity;
+}
+
+void ecs_command_buffer_free_entity(EcsCommandBuffer* buffer, EcsEntity entity) {
+    ecs_command_buffer_push(buffer, ECS_COMMAND_FREE, entity, NULL);
+}
+
+void ecs_command_buffer_set(EcsCommandBuffer* buffer, EcsEntity entity, EcsComponentManager* manager, const void* data) {
+    EcsCommand* command = ecs_command_buffer_push(buffer, ECS_COMMAND_SET, entity, manager);
+    if(data == NULL || manager->component_size == 0)
+        return;
+
+    // Each value starts at a suitably aligned offset so that a destructor can be called on it in place.
+    int size = manager->component_size;
+    buffer->data_count = (buffer->data_count + _Alignof(max_align_t) - 1) & ~(int)(_Alignof(max_align_t) - 1);
+    ECS_ARRAY_RESIZE(buffer->data, buffer->data_capacity, buffer->data_count + size, sizeof(char));
+    ecs_memcpy(buffer->data + buffer->data_count, data, size);
+    command->data = buffer->data_count;
+    buffer->data_count += size;
+}
+
+void ecs_command_buffer_remove(EcsCommandBuffer* buffer, EcsEntity entity, EcsComponentManager* manager) {
+    ecs_command_buffer_push(buffer, ECS_COMMAND_REMOVE, entity, manager);
+}
+
+void ecs_command_buffer_enable(EcsCommandBuffer* buffer, EcsEntity entity) {
+    ecs_command_buffer_push(buffer, ECS_COMMAND_ENABLE, entity, NULL);
+}
+
+void ecs_command_buffer_disable(EcsCommandBuffer* buffer, EcsEntity entity) {
+    ecs_command_buffer_push(buffer, ECS_COMMAND_DISABLE, entity, NULL);
+}
+
+int ecs_command_buffer_count(EcsCommandBuffer* buffer) {
+    return buffer->command_count;
+}
+
+EcsEntity ecs_command_buffer_resolve(EcsCommandBuffer* buffer, EcsEntity entity) {
+    if(entity.id >= 0)
+        return entity;
+
+    int index = ECS_COMMAND_PLACEHOLDER_INDEX(entity.id);
+    return index < buffer->create_count ? buffer->created[index] : entity;
+}
+
+static int ecs_command_compare(const void* left, const void* right) {
+    const EcsCommand* a = left;
+    const EcsCommand* b = right;
+
+    if(a->entity.id != b->entity.id)
+        return a->entity.id < b->entity.id ? -1 : 1;
+
+    return a->sequence - b->sequence;
+}
+
+// Marks the commands of a single entity that are overridden by a later command of the same entity.
+static void ecs_command_buffer_coalesce(EcsCommand* commands, int count) {
+    for(int i = 0; i < count; ++i) {
+        if(commands[i].type == ECS_COMMAND_FREE) {
+            // Freeing the entity removes everything else, so only the first free is kept.
+            for(int j = 0; j < count; ++j)
+                commands[j].skip = j != i;
+            return;
+        }
+    }
+
+    for(int i = 0; i < count; ++i) {
+        EcsCommand* command = commands + i;
+        bool component = command->type == ECS_COMMAND_SET || command->type == ECS_COMMAND_REMOVE;
+
+        for(int j = i + 1; j < count && !command->skip; ++j) {
+            EcsCommand* later = commands + j;
+            if(component)
+                command->skip = (later->type == ECS_COMMAND_SET || later->type == ECS_COMMAND_REMOVE) && later->manager == command->manager;
+            else
+                command->skip = later->type == ECS_COMMAND_ENABLE || later->type == ECS_COMMAND_DISABLE;
+        }
+    }
+}
+
+static void ecs_command_buffer_apply(EcsCommandBuffer* buffer, EcsCommand* command) {
+    switch(command->type) {
+        case ECS_COMMAND_FREE:
+            ecs_entity_free(command->entity);
+            break;
+        case ECS_COMMAND_SET:
+        {
+            void* component = ecs_component_set(command->entity, command->manager);
+            if(component == NULL) {
+                ecs_command_buffer_discard(buffer, command);
+            } else if(command->data != -1) {
+                if(command->manager->destructor != NULL)
+                    command->manager->destructor(component);
+
+                ecs_memcpy(component, buffer->data + command->data, command->manager->component_size);
+            }
+            break;
+        }
+        case ECS_COMMAND_REMOVE:
+            ecs_component_remove(command->entity, command->manager);
+            break;
+        case ECS_COMMAND_ENABLE:
+            ecs_entity_enable(command->entity);
+            break;
+        case ECS_COMMAND_DISABLE:
+            ecs_entity_disable(command->entity);
+            break;
+        case ECS_COMMAND_CREATE:
+            break;
+    }
+}
+
+void ecs_command_buffer_playback(EcsCommandBuffer* buffer) {
+    // Create the entities first so that the placeholders can be replaced before sorting.
+    buffer->create_count = 0;
+    for(int i = 0; i < buffer->command_count; ++i) {
+        if(buffer->commands[i].type != ECS_COMMAND_CREATE)
+            continue;
+
+        ECS_ARRAY_RESIZE(buffer->created, buffer->created_capacity, buffer->create_count, sizeof(EcsEntity));
+        buffer->created[buffer->create_count++] = ecs_create_entity(buffer->world);
+        buffer->commands[i].skip = true;
+    }
+
+    for(int i = 0; i < buffer->command_count; ++i)
+        buffer->commands[i].entity = ecs_command_buffer_resolve(buffer, buffer->commands[i].entity);
+
+    qsort(buffer->commands, buffer->command_count, sizeof(EcsCommand), ecs_command_compare);
+
+    for(int start = 0; start < buffer->command_count;) {
+        int end = start + 1;
+        while(end < buffer->command_count && buffer->commands[end].entity.id == buffer->commands[start].entity.id)
+            ++end;
+
+        ecs_command_buffer_coalesce(buffer->commands + start, end - start);
+
+        for(int i = start; i < end; ++i) {
+            if(buffer->commands[i].skip)
+                ecs_command_buffer_discard(buffer, buffer->commands + i);
+            else
+                ecs_command_buffer_apply(buffer, buffer->commands + i);
+        }
+
+        start = end;
+    }
+
+    buffer->command_count = 0;
+    buffer->placeholder_count = 0;
+    buffer->data_count = 0;
+}
@@ -1,74 +1,117 @@
 #include "ecs_component.h"
+#include "ecs_archetype.h"
+#include "ecs_component_group.h"
 
 #include <stdio.h>
 
-#include "ecs_int_dispenser.h"
 #include "ecs_event.h"
 #include "ecs_messages.h"
 #include "ecs_world.h"
 
-// Creates a link between two entities to the same component.
-typedef struct ComponentLink {
-    int entity_id;
-    int references;
-} ComponentLink;
-
-static ComponentLink DEFAULT_COMPONENT_LINK = {0};
-
-// Manages a specific type of component in a world.
-typedef struct EcsComponentPool {
-    int world;
-    int component_size;
-    char* components;
-    int component_count;
-    int* mapping;
-    int mapping_count;
-    ComponentLink* links;
-    int link_count;
-    int last_component_index;
-    int entity_disposed_id;
-} EcsComponentPool;
+static ComponentLink DEFAULT_COMPONENT_LINK = { 0, 0, -1 };
+
+// Updates the mapping of the owner(s) of the link at the specified index after it has been moved.
+static inline void ecs_component_pool_relink(EcsComponentPool* pool, int index) {
+    ComponentLink* link = pool->links + index;
+    if(link->share != -1)
+        pool->share_targets[link->share] = index;
+    else
+        ecs_sparse_map_set(&pool->mapping, link->entity_id, index << 1);
+}
+
+// Records that the component at the specified index was changed during the current world tick.
+static inline void ecs_component_pool_touch(EcsComponentPool* pool, int index) {
+    if(pool->track_changes)
+        pool->versions[index] = ecs_world_get_tick(pool->world);
+}
+
+// Makes sure the pool can store a component at the specified index.
+// Chunked pools allocate new chunks instead of moving the existing components.
+static void ecs_component_pool_reserve(EcsComponentPool* pool, int index) {
+    if(pool->chunk_shift == 0) {
+        if(index < pool->component_count)
+            return;
+
+        int capacity = pool->component_count == 0 ? 4 : pool->component_count;
+        while(index >= capacity)
+            capacity *= 2;
+
+        pool->components = ecs_aligned_realloc(pool->components,
+                                               (size_t)pool->component_size * pool->component_count,
+                                               (size_t)pool->component_size * capacity,
+                                               pool->alignment);
+        if(pool->track_changes)
+            pool->versions = ecs_realloc(pool->versions, sizeof(unsigned int) * capacity);
+
+        pool->component_count = capacity;
+        return;
+    }
+
+    int chunk = index >> pool->chunk_shift;
+    ECS_ARRAY_RESIZE_DEFAULT(pool->chunks, pool->chunk_capacity, chunk, sizeof(*pool->chunks), NULL);
+
+    int old_count = pool->component_count;
+    while(index >= pool->component_count) {
+        pool->chunks[pool->component_count >> pool->chunk_shift] = ecs_aligned_malloc((size_t)pool->component_size << pool->chunk_shift, pool->alignment);
+        pool->component_count += 1 << pool->chunk_shift;
+    }
+
+    if(pool->track_changes && old_count != pool->component_count)
+        pool->versions = ecs_realloc(pool->versions, sizeof(unsigned int) * pool->component_count);
+}
 
 // Frees a previously create EcsComponentPool, calling the destructor on each active component if defined.
 // flag: The flag of the component that is being freed.
 //       If the world is being destroyed, this should be set to COMPONENT_FLAG_INVALID_MASK
 //       As all of the components will be cleared anyways.
 static void ecs_component_pool_free(EcsComponentPool* pool, EcsComponentDestructor destructor, ComponentFlag flag) {
-    if(pool->components != NULL) {
-        if(pool->mapping != NULL) {
-            if(destructor != NULL) {
-                for(int i = 0; i <= pool->last_component_index; ++i) {
-                    // Here we use the links because it is the only way to make sure there are no double frees in O(n)
-                    if(pool->links[i].references != 0) {
-                        destructor(pool->components + (pool->mapping[pool->links[i].entity_id] * pool->component_size));
-                    }
+    if(pool->component_count != 0) {
+        if(destructor != NULL) {
+            for(int i = 0; i <= pool->last_component_index; ++i) {
+                // Here we use the links because it is the only way to make sure there are no double frees in O(n)
+                if(pool->links[i].references != 0) {
+                    destructor(ecs_component_pool_at(pool, i));
                 }
             }
+        }
 
-            if(flag != COMPONENT_FLAG_INVALID_MASK) {
-                int throwaway;
-                ComponentEnum* components = ecs_world_get_components(pool->world, &throwaway);
-                for(int i = 0; i < pool->mapping_count; ++i) {
-                    if(pool->mapping[i] == -1)
-                        continue;
-                    ecs_component_enum_set_flag(components + i, flag, false);
-                }
-            }
+        if(flag != COMPONENT_FLAG_INVALID_MASK) {
+            int throwaway;
+            ComponentEnum* components = ecs_world_get_components(pool->world, &throwaway);
+            for(int i = ecs_sparse_map_next(&pool->mapping, 0); i != -1; i = ecs_sparse_map_next(&pool->mapping, i + 1))
+                ecs_component_enum_set_flag(components + i, flag, false);
         }
 
-        ecs_free(pool->components);
+        if(pool->chunk_shift == 0) {
+            ecs_aligned_free(pool->components, pool->alignment);
+        } else {
+            for(int i = 0; i < (pool->component_count >> pool->chunk_shift); ++i)
+                ecs_aligned_free(pool->chunks[i], pool->alignment);
+            ecs_free(pool->chunks);
+        }
     }
     
-    ecs_free(pool->mapping);
+    ecs_sparse_map_free_resources(&pool->mapping);
+    ecs_sparse_map_free_resources(&pool->share_next);
+    ecs_sparse_map_free_resources(&pool->share_prev);
+    ecs_dispenser_free_resources(&pool->share_dispenser);
+    ecs_free(pool->share_targets);
     ecs_free(pool->links);
+    ecs_free(pool->versions);
 
     ecs_event_unsubscribe(pool->world, ecs_entity_disposed, pool->entity_disposed_id);
 
+    if(pool->group != NULL)
+        ecs_component_group_detach(pool->group);
+
     ecs_free(pool);
 }
 
 static void component_on_world_disposed(void* data, EcsWorldDisposedMessage* message) {
     EcsComponentManager* manager = data;
+    if(message->world < manager->tag_subscription_count)
+        manager->tag_subscriptions[message->world] = -1;
+
     if(message->world < manager->pool_count && manager->pools[message->world] != NULL) {
         ecs_component_pool_free(manager->pools[message->world], manager->destructor, COMPONENT_FLAG_INVALID_MASK);
         manager->pools[message->world] = NULL;
@@ -81,39 +124,125 @@ static void component_on_entity_disposed(void* data, EcsEntityDisposedMessage* m
 }
 
 // Initializes a new EcsComponentPool.
-static EcsComponentPool* ecs_component_pool_init(int world, int component_size) {
+static EcsComponentPool* ecs_component_pool_init(int world, int component_size, int alignment, int chunk_shift, bool track_changes) {
     EcsComponentPool* pool = ecs_malloc(sizeof(EcsComponentPool));
     pool->world = world;
     pool->component_size = component_size;
+    pool->alignment = alignment;
     pool->components = NULL;
     pool->component_count = 0;
-    pool->mapping = NULL;
-    pool->mapping_count = 0;
+    pool->chunks = NULL;
+    pool->chunk_capacity = 0;
+    pool->chunk_shift = chunk_shift;
+    pool->versions = NULL;
+    pool->track_changes = track_changes;
+    ecs_sparse_map_init(&pool->mapping);
     pool->links = NULL;
     pool->link_count = 0;
     pool->last_component_index = -1;
+    pool->share_targets = NULL;
+    pool->share_capacity = 0;
+    ecs_dispenser_init(&pool->share_dispenser);
+    ecs_sparse_map_init(&pool->share_next);
+    ecs_sparse_map_init(&pool->share_prev);
+    pool->group = NULL;
     return pool;
 }
 
 EcsComponentManager* ecs_component_define(int component_size, EcsComponentConstructor constructor, EcsComponentDestructor destructor) {
     EcsComponentManager* manager = ecs_malloc(sizeof(EcsComponentManager));
     manager->flag = ecs_component_flag_get();
+    manager->storage = ECS_COMPONENT_STORAGE_POOL;
     manager->constructor = constructor;
     manager->destructor = destructor;
     manager->added = NULL;
     manager->removed = NULL;
+    manager->added_many = NULL;
+    manager->removed_many = NULL;
     manager->pools = NULL;
     manager->pool_count = 0;
+    manager->tag_subscriptions = NULL;
+    manager->tag_subscription_count = 0;
     manager->component_size = component_size;
+    manager->alignment = 0;
+    manager->chunk_shift = 0;
+    manager->track_changes = false;
     manager->world_disposed_id = ecs_event_add(ecs_world_disposed, ecs_closure(manager, component_on_world_disposed));
 
     return manager;
 }
 
+EcsComponentManager* ecs_component_define_aligned(int component_size, int alignment, EcsComponentConstructor constructor, EcsComponentDestructor destructor) {
+    int align = 1;
+    while(align < alignment && align < (1 << 30))
+        align <<= 1;
+
+    // Pad the size so that every component in the pool stays aligned, not just the first one.
+    EcsComponentManager* manager = ecs_component_define((component_size + align - 1) & ~(align - 1), constructor, destructor);
+    manager->alignment = align;
+
+    return manager;
+}
+
+EcsComponentManager* ecs_component_define_chunked(int component_size, int chunk_size, EcsComponentConstructor constructor, EcsComponentDestructor destructor) {
+    EcsComponentManager* manager = ecs_component_define(component_size, constructor, destructor);
+
+    // Chunks hold a power of two number of components so that an index can be split with a shift and a mask.
+    // A shift of 0 means the pool isn't chunked, so the smallest chunk holds 2 components.
+    int shift = 1;
+    while((1 << shift) < chunk_size && shift < 30)
+        ++shift;
+
+    manager->chunk_shift = shift;
+
+    return manager;
+}
+
+EcsComponentManager* ecs_component_define_archetype(int component_size, EcsComponentConstructor constructor, EcsComponentDestructor destructor) {
+    EcsComponentManager* manager = ecs_component_define(component_size, constructor, destructor);
+    manager->storage = ECS_COMPONENT_STORAGE_ARCHETYPE;
+    return manager;
+}
+
+EcsComponentManager* ecs_component_define_tag(void) {
+    EcsComponentManager* manager = ecs_component_define(0, NULL, NULL);
+    manager->storage = ECS_COMPONENT_STORAGE_TAG;
+    return manager;
+}
+
+EcsResult ecs_component_track_changes(EcsComponentManager* manager) {
+    if(manager->storage != ECS_COMPONENT_STORAGE_POOL || manager->pools != NULL)
+        return ECS_RESULT_INVALID_STATE;
+
+    manager->track_changes = true;
+    return ECS_RESULT_SUCCESS;
+}
+
 void ecs_component_free(EcsComponentManager* manager) {
+    if(manager->tag_subscriptions != NULL) {
+        for(int i = 0; i < manager->tag_subscription_count; i++) {
+            if(manager->tag_subscriptions[i] == -1)
+                continue;
+
+            // There's no list of the entities that own the tag, so every entity on the world is checked.
+            int entity_count;
+            ComponentEnum* components = ecs_world_get_components(i, &entity_count);
+            for(int entity = 0; entity < entity_count; ++entity)
+                ecs_component_enum_set_flag(components + entity, manager->flag, false);
+
+            ecs_event_unsubscribe(i, ecs_entity_disposed, manager->tag_subscriptions[i]);
+        }
+
+        ecs_free(manager->tag_subscriptions);
+    }
+
     if(manager->pools != NULL) {
         for(int i = 0; i < manager->pool_count; i++) {
             if(manager->pools[i] != NULL) {
+                // Archetype components don't live in the pool, it's only used to listen for disposed entities.
+                if(manager->storage == ECS_COMPONENT_STORAGE_ARCHETYPE)
+                    ecs_archetype_clear(i, manager);
+
                 ecs_component_pool_free(manager->pools[i], manager->destructor, manager->flag);
             }
         }
@@ -127,6 +256,12 @@ void ecs_component_free(EcsComponentManager* manager) {
     if(manager->removed != NULL)
         ecs_event_manager_free(manager->removed);
 
+    if(manager->added_many != NULL)
+        ecs_event_manager_free(manager->added_many);
+
+    if(manager->removed_many != NULL)
+        ecs_event_manager_free(manager->removed_many);
+
     ecs_event_remove(ecs_world_disposed, manager->world_disposed_id);
 
     ecs_free(manager);
@@ -138,7 +273,7 @@ static EcsComponentPool* ecs_component_pool_get_or_create(EcsComponentManager* m
 
         ECS_ARRAY_RESIZE_DEFAULT(manager->pools, manager->pool_count, world, sizeof(*manager->pools), NULL);
 
-        EcsComponentPool* result = ecs_component_pool_init(world, manager->component_size);
+        EcsComponentPool* result = ecs_component_pool_init(world, manager->component_size, manager->alignment, manager->chunk_shift, manager->track_changes);
         result->entity_disposed_id = ecs_event_subscribe(world, ecs_entity_disposed, ecs_closure(manager, component_on_entity_disposed));
 
         manager->pools[world] = result;
@@ -149,6 +284,70 @@ static EcsComponentPool* ecs_component_pool_get_or_create(EcsComponentManager* m
     }
 }
 
+EcsComponentPool* ecs_component_get_pool(EcsWorld world, EcsComponentManager* manager) {
+    if(manager->storage != ECS_COMPONENT_STORAGE_POOL)
+        return NULL;
+
+    return ecs_component_pool_get_or_create(manager, world);
+}
+
+// Makes sure that entities on the specified world lose a tag component when they're freed.
+static void ecs_component_tag_subscribe(EcsComponentManager* manager, int world) {
+    if(world < manager->tag_subscription_count && manager->tag_subscriptions[world] != -1)
+        return;
+
+    ECS_ARRAY_RESIZE_DEFAULT(manager->tag_subscriptions, manager->tag_subscription_count, world, sizeof(int), -1);
+    manager->tag_subscriptions[world] = ecs_event_subscribe(world, ecs_entity_disposed, ecs_closure(manager, component_on_entity_disposed));
+}
+
+// Removes the component at the specified index from an entity, destroying it if it is no longer referenced.
+// Does not update the ComponentEnum of the entity or publish any events.
+static void ecs_component_pool_remove(EcsComponentPool* pool, EcsComponentManager* manager, int entity_id, int index) {
+    if(pool->group != NULL) {
+        // Leaving the group can move the component to the end of the group.
+        ecs_component_group_on_remove(pool->group, entity_id);
+        index = ecs_component_pool_lookup(pool, entity_id);
+    }
+
+    ecs_sparse_map_remove(&pool->mapping, entity_id);
+
+    ComponentLink* link = pool->links + index;
+    if(link->share != -1) {
+        // Unlink the entity from the sharer ring. The ring always has at least two entities here.
+        int next = ecs_sparse_map_get(&pool->share_next, entity_id);
+        int prev = ecs_sparse_map_get(&pool->share_prev, entity_id);
+        ecs_sparse_map_set(&pool->share_next, prev, next);
+        ecs_sparse_map_set(&pool->share_prev, next, prev);
+        ecs_sparse_map_remove(&pool->share_next, entity_id);
+        ecs_sparse_map_remove(&pool->share_prev, entity_id);
+
+        if(link->entity_id == entity_id)
+            link->entity_id = next;
+
+        if(--link->references == 1) {
+            // Only one entity is left, so it goes back to referencing the component directly.
+            ecs_sparse_map_remove(&pool->share_next, next);
+            ecs_sparse_map_remove(&pool->share_prev, next);
+            ecs_dispenser_release(&pool->share_dispenser, link->share);
+            link->share = -1;
+            ecs_sparse_map_set(&pool->mapping, next, index << 1);
+        }
+    } else if(--link->references == 0) {
+        if(manager->destructor != NULL)
+            manager->destructor(ecs_component_pool_at(pool, index));
+
+        if(index != pool->last_component_index) {
+            pool->links[index] = pool->links[pool->last_component_index];
+            ecs_memmove(ecs_component_pool_at(pool, index), ecs_component_pool_at(pool, pool->last_component_index), pool->component_size);
+            if(pool->track_changes)
+                pool->versions[index] = pool->versions[pool->last_component_index];
+            ecs_component_pool_relink(pool, index);
+        }
+
+        --pool->last_component_index;
+    }
+}
+
 #define ECS_COMPONENT_ADDED(entity, components, manager, result) \
     if(manager->added != NULL && ecs_component_enum_get_flag(components, ecs_is_enabled_flag)) { \
         ecs_event_publish(entity.world,  \
@@ -160,13 +359,43 @@ static EcsComponentPool* ecs_component_pool_get_or_create(EcsComponentManager* m
 void* ecs_component_set(EcsEntity entity, EcsComponentManager* manager) {
     ComponentEnum* components;
     void* result;
+
+    if(manager->storage == ECS_COMPONENT_STORAGE_TAG) {
+        components = ecs_entity_get_components(entity);
+        if(!ecs_component_enum_get_flag(components, manager->flag)) {
+            ecs_component_tag_subscribe(manager, entity.world);
+            ecs_component_enum_set_flag(components, manager->flag, true);
+            ECS_COMPONENT_ADDED(entity, components, manager, NULL);
+        }
+
+        return NULL;
+    }
+
     EcsComponentPool* pool = ecs_component_pool_get_or_create(manager, entity.world);
 
-    ECS_ARRAY_RESIZE_DEFAULT(pool->mapping, pool->mapping_count, entity.id, sizeof(*pool->mapping), -1);
+    if(manager->storage == ECS_COMPONENT_STORAGE_ARCHETYPE) {
+        bool added;
+        result = ecs_archetype_set(entity, manager, &added);
 
-    int* index = pool->mapping + entity.id;
-    if(*index != -1) {
-        result = pool->components + (*index * pool->component_size);
+        if(!added && manager->destructor != NULL)
+            manager->destructor(result);
+
+        // The component is constructed before the event is published because a subscriber
+        // can move the entity to another table by adding or removing archetype components.
+        if(manager->constructor != NULL)
+            manager->constructor(result);
+
+        components = ecs_entity_get_components(entity);
+        ecs_component_enum_set_flag(components, manager->flag, true);
+        ECS_COMPONENT_ADDED(entity, components, manager, result);
+
+        return ecs_archetype_get(entity, manager);
+    }
+
+    int index = ecs_component_pool_lookup(pool, entity.id);
+    if(index != -1) {
+        result = ecs_component_pool_at(pool, index);
+        ecs_component_pool_touch(pool, index);
 
         components = ecs_entity_get_components(entity);
         ECS_COMPONENT_ADDED(entity, components, manager, result);
@@ -180,16 +409,24 @@ void* ecs_component_set(EcsEntity entity, EcsComponentManager* manager) {
         return result;
     }
 
-    *index = ++pool->last_component_index;
+    ecs_sparse_map_set(&pool->mapping, entity.id, ++pool->last_component_index << 1);
 
-    ECS_ARRAY_RESIZE(pool->components, pool->component_count, pool->last_component_index, pool->component_size);
+    ecs_component_pool_reserve(pool, pool->last_component_index);
 
     ECS_ARRAY_RESIZE_DEFAULT(pool->links, pool->link_count, pool->last_component_index, sizeof(*pool->links), DEFAULT_COMPONENT_LINK);
 
     pool->links[pool->last_component_index].entity_id = entity.id;
     pool->links[pool->last_component_index].references = 1;
+    pool->links[pool->last_component_index].share = -1;
+
+    index = pool->last_component_index;
+    if(pool->group != NULL) {
+        ecs_component_group_on_add(pool->group, entity.id);
+        index = ecs_component_pool_lookup(pool, entity.id);
+    }
 
-    result = pool->components + pool->component_size * pool->last_component_index;
+    result = ecs_component_pool_at(pool, index);
+    ecs_component_pool_touch(pool, index);
 
     components = ecs_entity_get_components(entity);
     ecs_component_enum_set_flag(components, manager->flag, true);
@@ -206,109 +443,601 @@ EcsResult ecs_component_set_same_as(EcsEntity entity, EcsEntity reference, EcsCo
     if(entity.world != reference.world)
         return ECS_RESULT_DIFFERENT_WORLD;
 
+    if(manager->storage != ECS_COMPONENT_STORAGE_POOL)
+        return ECS_RESULT_INVALID_STATE;
+
     if(!ecs_component_exists(reference, manager))
         return ECS_RESULT_INVALID_ENTITY;
 
     EcsComponentPool* pool = ecs_component_pool_get_or_create(manager, entity.world);
 
-    ECS_ARRAY_RESIZE_DEFAULT(pool->mapping, pool->mapping_count, entity.id, sizeof(*pool->mapping), -1);
+    // Grouped components have to line up with the components of the other owned pools, so they can't be shared.
+    if(pool->group != NULL)
+        return ECS_RESULT_INVALID_STATE;
 
-    int ref_index = pool->mapping[reference.id];
-    int* index = pool->mapping + entity.id;
+    int ref_index = ecs_component_pool_lookup(pool, reference.id);
+    int index = ecs_component_pool_lookup(pool, entity.id);
 
-    if(*index != -1) {
-        if(*index == ref_index)
+    if(index != -1) {
+        if(index == ref_index)
             return ECS_RESULT_SUCCESS;
 
         ecs_component_remove(entity, manager);
+
+        // Removing the component may have moved the referenced component.
+        ref_index = ecs_component_pool_lookup(pool, reference.id);
     }
 
-    ++pool->links[ref_index].references;
-    *index = ref_index;
+    ComponentLink* link = pool->links + ref_index;
+    if(link->share == -1) {
+        // The first time a component is shared, its owner is moved into a share slot and starts the sharer ring.
+        link->share = ecs_dispenser_get(&pool->share_dispenser);
+        ECS_ARRAY_RESIZE(pool->share_targets, pool->share_capacity, link->share, sizeof(*pool->share_targets));
+        pool->share_targets[link->share] = ref_index;
+        ecs_sparse_map_set(&pool->mapping, link->entity_id, (link->share << 1) | 1);
+        ecs_sparse_map_set(&pool->share_next, link->entity_id, link->entity_id);
+        ecs_sparse_map_set(&pool->share_prev, link->entity_id, link->entity_id);
+    }
+
+    int next = ecs_sparse_map_get(&pool->share_next, link->entity_id);
+    ecs_sparse_map_set(&pool->share_next, link->entity_id, entity.id);
+    ecs_sparse_map_set(&pool->share_prev, next, entity.id);
+    ecs_sparse_map_set(&pool->share_next, entity.id, next);
+    ecs_sparse_map_set(&pool->share_prev, entity.id, link->entity_id);
+
+    ++link->references;
+    ecs_sparse_map_set(&pool->mapping, entity.id, (link->share << 1) | 1);
 
     ComponentEnum* components = ecs_entity_get_components(entity);
     ecs_component_enum_set_flag(components, manager->flag, true);
-    ECS_COMPONENT_ADDED(entity, components, manager, &pool->components[pool->component_size * ref_index]);
+    ECS_COMPONENT_ADDED(entity, components, manager, ecs_component_pool_at(pool, ref_index));
 
     return ECS_RESULT_SUCCESS;
 }
 
-EcsResult ecs_component_remove(EcsEntity entity, EcsComponentManager* manager) {
-    EcsComponentPool* pool = ecs_component_pool_get_or_create(manager, entity.world);
+// Removes an archetype component from an entity.
+static EcsResult ecs_component_archetype_remove(EcsEntity entity, EcsComponentManager* manager) {
+    void* component = ecs_archetype_get(entity, manager);
+    if(component == NULL)
+        return ECS_RESULT_INVALID_ENTITY;
+
+    ComponentEnum* components = ecs_entity_get_components(entity);
+    ecs_component_enum_set_flag(components, manager->flag, false);
+    if(manager->removed != NULL && ecs_component_enum_get_flag(components, ecs_is_enabled_flag)) {
+        EcsComponentRemovedMessage message = { entity, manager, component };
+        ecs_event_publish(entity.world, manager->removed, void (*)(void*, EcsComponentRemovedMessage*), &message);
+
+        // A subscriber may have moved the entity to another table.
+        component = ecs_archetype_get(entity, manager);
+    }
+
+    if(manager->destructor != NULL)
+        manager->destructor(component);
+
+    ecs_archetype_remove(entity, manager);
+
+    return ECS_RESULT_SUCCESS;
+}
 
-    if(entity.id >= pool->mapping_count)
+// Removes a tag component from an entity.
+static EcsResult ecs_component_tag_remove(EcsEntity entity, EcsComponentManager* manager) {
+    ComponentEnum* components = ecs_entity_get_components(entity);
+    if(!ecs_component_enum_get_flag(components, manager->flag))
         return ECS_RESULT_INVALID_ENTITY;
 
-    int* index = pool->mapping + entity.id;
-    if(*index == -1)
+    ecs_component_enum_set_flag(components, manager->flag, false);
+    if(manager->removed != NULL && ecs_component_enum_get_flag(components, ecs_is_enabled_flag)) {
+        EcsComponentRemovedMessage message = { entity, manager, NULL };
+        ecs_event_publish(entity.world, manager->removed, void (*)(void*, EcsComponentRemovedMessage*), &message);
+    }
+
+    return ECS_RESULT_SUCCESS;
+}
+
+EcsResult ecs_component_remove(EcsEntity entity, EcsComponentManager* manager) {
+    if(manager->storage == ECS_COMPONENT_STORAGE_TAG)
+        return ecs_component_tag_remove(entity, manager);
+
+    if(manager->storage == ECS_COMPONENT_STORAGE_ARCHETYPE)
+        return ecs_component_archetype_remove(entity, manager);
+
+    EcsComponentPool* pool = ecs_component_find_pool(entity.world, manager);
+    int index = pool == NULL ? -1 : ecs_component_pool_lookup(pool, entity.id);
+    if(index == -1)
         return ECS_RESULT_INVALID_ENTITY;
 
     ComponentEnum* components = ecs_entity_get_components(entity);
     ecs_component_enum_set_flag(components, manager->flag, false);
     if(manager->removed != NULL && ecs_component_enum_get_flag(components, ecs_is_enabled_flag)) {
-        void* component = pool->components + pool->component_size * *index;
+        void* component = ecs_component_pool_at(pool, index);
         EcsComponentRemovedMessage message = { entity, manager, component };
         ecs_event_publish(entity.world, manager->removed, void (*)(void*, EcsComponentRemovedMessage*), &message);
     }
 
-    ComponentLink* link = pool->links + *index;
-    if(--link->references == 0) {
-        if(manager->destructor != NULL)
-            manager->destructor(pool->components + (pool->component_size * *index));
+    ecs_component_pool_remove(pool, manager, entity.id, index);
+
+    return ECS_RESULT_SUCCESS;
+}
+
+// Determines if every entity in an array belongs to the same world.
+static bool ecs_component_same_world(EcsEntity* entities, int count) {
+    for(int i = 1; i < count; ++i) {
+        if(entities[i].world != entities[0].world)
+            return false;
+    }
+
+    return true;
+}
+
+EcsResult ecs_component_set_many(EcsEntity* entities, int count, EcsComponentManager* manager, void** components) {
+    if(count <= 0)
+        return ECS_RESULT_SUCCESS;
+
+    if(!ecs_component_same_world(entities, count))
+        return ECS_RESULT_DIFFERENT_WORLD;
+
+    EcsWorld world = entities[0].world;
+    int entity_count;
+    ComponentEnum* entity_components = ecs_world_get_components(world, &entity_count);
+
+    if(manager->storage == ECS_COMPONENT_STORAGE_TAG) {
+        // Like ecs_component_set, only the entities that didn't have the tag yet are reported.
+        // Setting the flag of the first copy of an entity also filters out any duplicates.
+        EcsEntity* added = ecs_malloc(sizeof(EcsEntity) * count);
+        int added_count = 0;
+
+        ecs_component_tag_subscribe(manager, world);
+        for(int i = 0; i < count; ++i) {
+            if(components != NULL)
+                components[i] = NULL;
+
+            if(ecs_component_enum_get_flag(entity_components + entities[i].id, manager->flag))
+                continue;
+
+            ecs_component_enum_set_flag(entity_components + entities[i].id, manager->flag, true);
+            added[added_count++] = entities[i];
+        }
+
+        if(manager->added_many != NULL && added_count != 0) {
+            EcsComponentAddedManyMessage message = { added, added_count, manager };
+            ecs_event_publish(world, manager->added_many, void (*)(void*, EcsComponentAddedManyMessage*), &message);
+        }
+
+        ecs_free(added);
+        return ECS_RESULT_SUCCESS;
+    }
+
+    EcsComponentPool* pool = ecs_component_pool_get_or_create(manager, world);
 
-        ComponentLink last_link = pool->links[pool->last_component_index];
-        pool->links[*index] = last_link;
-        ecs_memmove(pool->components + (pool->component_size * *index), pool->components + (pool->component_size * pool->last_component_index), pool->component_size);
-        if(last_link.references == 1) {
-            pool->mapping[last_link.entity_id] = *index;
+    if(manager->storage == ECS_COMPONENT_STORAGE_POOL) {
+        // Reserve enough room for every entity up front so the storage grows at most once.
+        ecs_component_pool_reserve(pool, pool->last_component_index + count);
+        ECS_ARRAY_RESIZE_DEFAULT(pool->links, pool->link_count, pool->last_component_index + count, sizeof(*pool->links), DEFAULT_COMPONENT_LINK);
+    }
+
+    for(int i = 0; i < count; ++i) {
+        int id = entities[i].id;
+        void* result;
+        int index = ecs_component_pool_lookup(pool, id);
+
+        if(manager->storage == ECS_COMPONENT_STORAGE_ARCHETYPE) {
+            bool added;
+            result = ecs_archetype_set(entities[i], manager, &added);
+            if(!added && manager->destructor != NULL)
+                manager->destructor(result);
+
+            ecs_component_enum_set_flag(entity_components + id, manager->flag, true);
+        } else if(index != -1) {
+            result = ecs_component_pool_at(pool, index);
+            ecs_component_pool_touch(pool, index);
+            if(manager->destructor != NULL)
+                manager->destructor(result);
         } else {
-            for(int i = 0; i < pool->mapping_count; ++i) {
-                if(pool->mapping[i] == pool->last_component_index)
-                    pool->mapping[i] = *index;
+            index = ++pool->last_component_index;
+            ecs_sparse_map_set(&pool->mapping, id, index << 1);
+
+            pool->links[index].entity_id = id;
+            pool->links[index].references = 1;
+            pool->links[index].share = -1;
+
+            if(pool->group != NULL) {
+                ecs_component_group_on_add(pool->group, id);
+                index = ecs_component_pool_lookup(pool, id);
             }
+
+            result = ecs_component_pool_at(pool, index);
+            ecs_component_pool_touch(pool, index);
+            ecs_component_enum_set_flag(entity_components + id, manager->flag, true);
         }
 
-        --pool->last_component_index;
-    } else if(link->entity_id == entity.id) {
-        int link_index = *index;
-        for(int i = 0; i < pool->mapping_count; ++i) {
-            if(pool->mapping[i] == link_index && i != entity.id) {
-                link->entity_id = i;
-                break;
-            }
+        if(manager->constructor != NULL)
+            manager->constructor(result);
+
+        if(components != NULL)
+            components[i] = result;
+    }
+
+    // Adding archetype components to other entities can grow the tables, so they are looked up once every entity was added.
+    // The same goes for grouped components, which can be moved when a later entity joins the group.
+    if(components != NULL && manager->storage == ECS_COMPONENT_STORAGE_ARCHETYPE) {
+        for(int i = 0; i < count; ++i)
+            components[i] = ecs_archetype_get(entities[i], manager);
+    } else if(components != NULL && pool->group != NULL) {
+        for(int i = 0; i < count; ++i)
+            components[i] = ecs_component_pool_get(pool, entities[i]);
+    }
+
+    if(manager->added_many != NULL) {
+        EcsComponentAddedManyMessage message = { entities, count, manager };
+        ecs_event_publish(world, manager->added_many, void (*)(void*, EcsComponentAddedManyMessage*), &message);
+    }
+
+    return ECS_RESULT_SUCCESS;
+}
+
+EcsResult ecs_component_remove_many(EcsEntity* entities, int count, EcsComponentManager* manager) {
+    if(count <= 0)
+        return ECS_RESULT_SUCCESS;
+
+    if(!ecs_component_same_world(entities, count))
+        return ECS_RESULT_DIFFERENT_WORLD;
+
+    EcsWorld world = entities[0].world;
+    int entity_count;
+    ComponentEnum* entity_components = ecs_world_get_components(world, &entity_count);
+
+    // Only the entities that actually own the component are removed and reported.
+    // The flag is cleared for the first copy of an entity, so any duplicates are skipped.
+    EcsEntity* removed = ecs_malloc(sizeof(EcsEntity) * count);
+    int removed_count = 0;
+
+    for(int i = 0; i < count; ++i) {
+        if(!ecs_component_enum_get_flag(entity_components + entities[i].id, manager->flag))
+            continue;
+
+        ecs_component_enum_set_flag(entity_components + entities[i].id, manager->flag, false);
+        removed[removed_count++] = entities[i];
+    }
+
+    if(manager->removed_many != NULL && removed_count != 0) {
+        EcsComponentRemovedManyMessage message = { removed, removed_count, manager };
+        ecs_event_publish(world, manager->removed_many, void (*)(void*, EcsComponentRemovedManyMessage*), &message);
+    }
+
+    if(manager->storage == ECS_COMPONENT_STORAGE_TAG) {
+        ecs_free(removed);
+        return ECS_RESULT_SUCCESS;
+    }
+
+    EcsComponentPool* pool = ecs_component_pool_get_or_create(manager, world);
+
+    for(int i = 0; i < removed_count; ++i) {
+        // The index is looked up again because a previous removal may have moved the component.
+        if(manager->storage == ECS_COMPONENT_STORAGE_ARCHETYPE) {
+            void* component = ecs_archetype_get(removed[i], manager);
+            if(component == NULL)
+                continue;
+
+            if(manager->destructor != NULL)
+                manager->destructor(component);
+
+            ecs_archetype_remove(removed[i], manager);
+            continue;
         }
+
+        int index = ecs_component_pool_lookup(pool, removed[i].id);
+        if(index != -1)
+            ecs_component_pool_remove(pool, manager, removed[i].id, index);
     }
 
-    *index = -1;
+    ecs_free(removed);
 
     return ECS_RESULT_SUCCESS;
 }
 
 EcsResult ecs_component_get(EcsEntity entity, EcsComponentManager* manager, void** data) {
-    EcsComponentPool* pool = ecs_component_pool_get_or_create(manager, entity.world);
+    if(manager->storage == ECS_COMPONENT_STORAGE_TAG) {
+        if(!ecs_component_exists(entity, manager))
+            return ECS_RESULT_INVALID_ENTITY;
 
-    if(entity.id >= pool->mapping_count)
+        *data = NULL;
+        return ECS_RESULT_SUCCESS;
+    }
+
+    if(manager->storage == ECS_COMPONENT_STORAGE_ARCHETYPE) {
+        void* component = ecs_archetype_get(entity, manager);
+        if(component == NULL)
+            return ECS_RESULT_INVALID_ENTITY;
+
+        *data = component;
+        return ECS_RESULT_SUCCESS;
+    }
+
+    // Looking up a component never creates the pool, an entity can't own a component without one.
+    EcsComponentPool* pool = ecs_component_find_pool(entity.world, manager);
+    void* component = pool == NULL ? NULL : ecs_component_pool_get(pool, entity);
+    if(component == NULL)
         return ECS_RESULT_INVALID_ENTITY;
 
-    int index = pool->mapping[entity.id];
+    *data = component;
+    return ECS_RESULT_SUCCESS;
+}
+
+EcsResult ecs_component_get_mut(EcsEntity entity, EcsComponentManager* manager, void** data) {
+    EcsResult result = ecs_component_get(entity, manager, data);
+    if(result == ECS_RESULT_SUCCESS && manager->track_changes)
+        ecs_component_mark_changed(entity, manager);
+
+    return result;
+}
+
+EcsResult ecs_component_mark_changed(EcsEntity entity, EcsComponentManager* manager) {
+    if(!manager->track_changes)
+        return ecs_component_exists(entity, manager) ? ECS_RESULT_SUCCESS : ECS_RESULT_INVALID_ENTITY;
+
+    EcsComponentPool* pool = ecs_component_find_pool(entity.world, manager);
+    int index = pool == NULL ? -1 : ecs_component_pool_lookup(pool, entity.id);
     if(index == -1)
         return ECS_RESULT_INVALID_ENTITY;
 
-    *data = pool->components + (index * pool->component_size);
+    ecs_component_pool_touch(pool, index);
     return ECS_RESULT_SUCCESS;
 }
 
-bool ecs_component_exists(EcsEntity entity, EcsComponentManager* manager) {
-    EcsComponentPool* pool = ecs_component_pool_get_or_create(manager, entity.world);
+bool ecs_component_changed_since(EcsEntity entity, EcsComponentManager* manager, unsigned int tick) {
+    if(!manager->track_changes)
+        return ecs_component_exists(entity, manager);
+
+    EcsComponentPool* pool = ecs_component_find_pool(entity.world, manager);
+    int index = pool == NULL ? -1 : ecs_component_pool_lookup(pool, entity.id);
+    return index != -1 && pool->versions[index] > tick;
+}
 
-    if(entity.id >= pool->mapping_count)
-        return false;
+bool ecs_component_exists(EcsEntity entity, EcsComponentManager* manager) {
+    if(manager->storage == ECS_COMPONENT_STORAGE_ARCHETYPE)
+        return ecs_archetype_get(entity, manager) != NULL;
 
-    return pool->mapping[entity.id] != -1;
+    return ecs_component_has(entity, manager);
 }
 
 void* ecs_component_get_all(EcsWorld world, EcsComponentManager* manager, int* count) {
-    EcsComponentPool* pool = ecs_component_pool_get_or_create(manager, world);
+    // Chunked and archetype components aren't stored in a single array, so returning the first chunk
+    // would silently hide the rest of them. They have to be read with ecs_component_get_chunk.
+    EcsComponentPool* pool = ecs_component_find_pool(world, manager);
+    if(pool == NULL || pool->chunk_shift != 0) {
+        *count = 0;
+        return NULL;
+    }
+
     *count = pool->last_component_index + 1;
     return pool->components;
+}
+
+void* ecs_component_get_chunk(EcsWorld world, EcsComponentManager* manager, int chunk, int* count) {
+    if(manager->storage == ECS_COMPONENT_STORAGE_ARCHETYPE)
+        return ecs_archetype_get_column(world, manager, chunk, count);
+
+    if(manager->storage == ECS_COMPONENT_STORAGE_TAG) {
+        *count = 0;
+        return NULL;
+    }
+
+    // Only look the pool up so that reading never allocates, which lets systems read from several threads at once.
+    EcsComponentPool* pool = ecs_component_find_pool(world, manager);
+    if(pool == NULL) {
+        *count = 0;
+        return NULL;
+    }
+
+    int total = pool->last_component_index + 1;
+
+    if(pool->chunk_shift == 0) {
+        *count = chunk == 0 ? total : 0;
+        return chunk == 0 && total != 0 ? pool->components : NULL;
+    }
+
+    int start = chunk << pool->chunk_shift;
+    if(chunk < 0 || start >= total) {
+        *count = 0;
+        return NULL;
+    }
+
+    int chunk_size = 1 << pool->chunk_shift;
+    *count = total - start < chunk_size ? total - start : chunk_size;
+    return pool->chunks[chunk];
+}
+
+unsigned int* ecs_component_get_versions(EcsWorld world, EcsComponentManager* manager, int chunk, int* count) {
+    *count = 0;
+    if(!manager->track_changes)
+        return NULL;
+
+    // The versions are stored contiguously, so a chunk is just an offset into the array.
+    EcsComponentPool* pool = ecs_component_find_pool(world, manager);
+    if(pool == NULL || ecs_component_get_chunk(world, manager, chunk, count) == NULL)
+        return NULL;
+
+    return pool->versions + (chunk << pool->chunk_shift);
+}
+
+// Gets the pool to sort, which can be NULL if no entity on the world ever owned the component type.
+static EcsResult ecs_component_sort_pool(EcsWorld world, EcsComponentManager* manager, EcsComponentPool** pool) {
+    if(manager->storage != ECS_COMPONENT_STORAGE_POOL)
+        return ECS_RESULT_INVALID_STATE;
+
+    *pool = ecs_component_find_pool(world, manager);
+    if(*pool != NULL && (*pool)->group != NULL)
+        return ECS_RESULT_INVALID_STATE;
+
+    return ECS_RESULT_SUCCESS;
+}
+
+// Creates the identity order of the components of a pool. order[i] is the index of the component that should end up at i.
+static int* ecs_component_sort_order_init(EcsComponentPool* pool) {
+    int count = pool->last_component_index + 1;
+    int* order = ecs_malloc(sizeof(int) * count);
+    for(int i = 0; i < count; ++i)
+        order[i] = i;
+
+    return order;
+}
+
+// Moves every component of a pool to its sorted position by following the cycles of the order,
+// so each component is only copied once. The order is consumed in the process.
+static void ecs_component_pool_permute(EcsComponentPool* pool, int* order) {
+    int count = pool->last_component_index + 1;
+    char* held = ecs_malloc(pool->component_size > 0 ? pool->component_size : 1);
+
+    for(int start = 0; start < count; ++start) {
+        // Components that are already in place or were moved by a previous cycle are marked with -1.
+        if(order[start] == start || order[start] == -1)
+            continue;
+
+        ecs_memcpy(held, ecs_component_pool_at(pool, start), pool->component_size);
+        ComponentLink held_link = pool->links[start];
+        unsigned int held_version = pool->track_changes ? pool->versions[start] : 0;
+
+        int target = start;
+        while(order[target] != start) {
+            int source = order[target];
+            ecs_memcpy(ecs_component_pool_at(pool, target), ecs_component_pool_at(pool, source), pool->component_size);
+            pool->links[target] = pool->links[source];
+            if(pool->track_changes)
+                pool->versions[target] = pool->versions[source];
+
+            ecs_component_pool_relink(pool, target);
+            order[target] = -1;
+            target = source;
+        }
+
+        ecs_memcpy(ecs_component_pool_at(pool, target), held, pool->component_size);
+        pool->links[target] = held_link;
+        if(pool->track_changes)
+            pool->versions[target] = held_version;
+
+        ecs_component_pool_relink(pool, target);
+        order[target] = -1;
+    }
+
+    ecs_free(held);
+}
+
+EcsResult ecs_component_sort(EcsWorld world, EcsComponentManager* manager, EcsComponentCompare compare) {
+    EcsComponentPool* pool;
+    EcsResult result = ecs_component_sort_pool(world, manager, &pool);
+    if(result != ECS_RESULT_SUCCESS || pool == NULL || pool->last_component_index < 1)
+        return result;
+
+    int count = pool->last_component_index + 1;
+    int* order = ecs_component_sort_order_init(pool);
+    int* buffer = ecs_malloc(sizeof(int) * count);
+
+    // A bottom up merge sort, which is stable and doesn't need to pass the pool to the compare function.
+    for(int width = 1; width < count; width *= 2) {
+        for(int left = 0; left < count; left += 2 * width) {
+            int middle = left + width < count ? left + width : count;
+            int right = left + 2 * width < count ? left + 2 * width : count;
+            int i = left, j = middle, k = left;
+
+            while(i < middle && j < right) {
+                if(compare(ecs_component_pool_at(pool, order[j]), ecs_component_pool_at(pool, order[i])) < 0)
+                    buffer[k++] = order[j++];
+                else
+                    buffer[k++] = order[i++];
+            }
+
+            while(i < middle)
+                buffer[k++] = order[i++];
+
+            while(j < right)
+                buffer[k++] = order[j++];
+        }
+
+        int* swap = order;
+        order = buffer;
+        buffer = swap;
+    }
+
+    ecs_component_pool_permute(pool, order);
+
+    ecs_free(order);
+    ecs_free(buffer);
+
+    return ECS_RESULT_SUCCESS;
+}
+
+EcsResult ecs_component_sort_incremental(EcsWorld world, EcsComponentManager* manager, EcsComponentCompare compare) {
+    EcsComponentPool* pool;
+    EcsResult result = ecs_component_sort_pool(world, manager, &pool);
+    if(result != ECS_RESULT_SUCCESS || pool == NULL || pool->last_component_index < 1)
+        return result;
+
+    int count = pool->last_component_index + 1;
+    int* order = ecs_component_sort_order_init(pool);
+
+    for(int i = 1; i < count; ++i) {
+        int current = order[i];
+        void* component = ecs_component_pool_at(pool, current);
+
+        int j = i - 1;
+        while(j >= 0 && compare(ecs_component_pool_at(pool, order[j]), component) > 0) {
+            order[j + 1] = order[j];
+            --j;
+        }
+
+        order[j + 1] = current;
+    }
+
+    ecs_component_pool_permute(pool, order);
+    ecs_free(order);
+
+    return ECS_RESULT_SUCCESS;
+}
+
+EcsResult ecs_component_sort_by_key(EcsWorld world, EcsComponentManager* manager, EcsComponentSortKey key) {
+    EcsComponentPool* pool;
+    EcsResult result = ecs_component_sort_pool(world, manager, &pool);
+    if(result != ECS_RESULT_SUCCESS || pool == NULL || pool->last_component_index < 1)
+        return result;
+
+    int count = pool->last_component_index + 1;
+    int* order = ecs_component_sort_order_init(pool);
+    int* buffer = ecs_malloc(sizeof(int) * count);
+    uint32_t* keys = ecs_malloc(sizeof(uint32_t) * count);
+
+    for(int i = 0; i < count; ++i)
+        keys[i] = key(ecs_component_pool_at(pool, i));
+
+    // A least significant digit radix sort, one byte at a time.
+    for(int shift = 0; shift < 32; shift += 8) {
+        int offsets[256] = { 0 };
+        for(int i = 0; i < count; ++i)
+            offsets[(keys[i] >> shift) & 0xFF]++;
+
+        // Skip the pass if every key has the same byte, which is common for small keys.
+        if(offsets[(keys[0] >> shift) & 0xFF] == count)
+            continue;
+
+        int total = 0;
+        for(int digit = 0; digit < 256; ++digit) {
+            int digit_count = offsets[digit];
+            offsets[digit] = total;
+            total += digit_count;
+        }
+
+        for(int i = 0; i < count; ++i)
+            buffer[offsets[(keys[order[i]] >> shift) & 0xFF]++] = order[i];
+
+        int* swap = order;
+        order = buffer;
+        buffer = swap;
+    }
+
+    ecs_component_pool_permute(pool, order);
+
+    ecs_free(keys);
+    ecs_free(order);
+    ecs_free(buffer);
+
+    return ECS_RESULT_SUCCESS;
 }
\ No newline at end of file
@@ -1,4 +1,126 @@
 #include "ecs_component_flag.h"
+#include "ecs_context.h"
 
-ComponentFlag ___ecs_last_component_flag = 1;
-ComponentEnum COMPONENT_ENUM_DEFAULT = { NULL, 0 };
\ No newline at end of file
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define ECS_MATCH_AVX2
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ECS_MATCH_SSE2
+#endif
+
+ComponentEnum COMPONENT_ENUM_DEFAULT = { 0 };
+
+ComponentFlag ecs_component_flag_get(void) {
+    EcsContext* context = ecs_context_get_current();
+    ComponentFlag flag = context->last_component_flag;
+    context->last_component_flag = (flag & COMPONENT_FLAG_BIT_MASK) != 0x80000000 ? ((flag & COMPONENT_FLAG_INDEX_MASK) | ((flag & COMPONENT_FLAG_BIT_MASK) << 1)) :
+                                                                                   ((flag & COMPONENT_FLAG_INDEX_MASK) + 0x100000000) + 1;
+
+    return flag;
+}
+
+// The inline words of a filter, padded with zeroes so they can always be loaded in full.
+typedef struct EcsMatchFilter {
+    unsigned int with[ECS_COMPONENT_ENUM_INLINE_WORDS];
+    unsigned int without[ECS_COMPONENT_ENUM_INLINE_WORDS];
+} EcsMatchFilter;
+
+// Checks a single signature stored inline. Returns 1 if it matches, 0 otherwise.
+static inline int ecs_component_enum_match_inline(const unsigned int* words, const EcsMatchFilter* filter) {
+#if defined(ECS_MATCH_SSE2) && ECS_COMPONENT_ENUM_INLINE_WORDS % 4 == 0
+    __m128i result = _mm_set1_epi32(-1);
+    for(int i = 0; i < ECS_COMPONENT_ENUM_INLINE_WORDS; i += 4) {
+        __m128i value = _mm_loadu_si128((const __m128i*)(words + i));
+        __m128i with = _mm_loadu_si128((const __m128i*)(filter->with + i));
+        __m128i without = _mm_loadu_si128((const __m128i*)(filter->without + i));
+
+        __m128i has_with = _mm_cmpeq_epi32(_mm_and_si128(value, with), with);
+        __m128i has_without = _mm_cmpeq_epi32(_mm_and_si128(value, without), _mm_setzero_si128());
+        result = _mm_and_si128(result, _mm_and_si128(has_with, has_without));
+    }
+
+    return _mm_movemask_epi8(result) == 0xFFFF;
+#else
+    // Accumulate any mismatching bits instead of returning early so the loop has no branches.
+    unsigned int missing = 0;
+    for(int i = 0; i < ECS_COMPONENT_ENUM_INLINE_WORDS; ++i)
+        missing |= ((words[i] & filter->with[i]) ^ filter->with[i]) | (words[i] & filter->without[i]);
+
+    return missing == 0;
+#endif
+}
+
+#if defined(ECS_MATCH_AVX2) && ECS_COMPONENT_ENUM_INLINE_WORDS == 4
+// Checks two signatures stored inline using one 256 bit register. Returns a two bit mask of the matches.
+static inline int ecs_component_enum_match_inline_pair(const unsigned int* first, const unsigned int* second, __m256i with, __m256i without) {
+    __m256i value = _mm256_set_m128i(_mm_loadu_si128((const __m128i*)second), _mm_loadu_si128((const __m128i*)first));
+    __m256i has_with = _mm256_cmpeq_epi32(_mm256_and_si256(value, with), with);
+    __m256i has_without = _mm256_cmpeq_epi32(_mm256_and_si256(value, without), _mm256_setzero_si256());
+    unsigned int bits = (unsigned int)_mm256_movemask_epi8(_mm256_and_si256(has_with, has_without));
+
+    return (bits & 0xFFFFu) == 0xFFFFu ? (((bits >> 16) == 0xFFFFu) ? 3 : 1) : (((bits >> 16) == 0xFFFFu) ? 2 : 0);
+}
+#endif
+
+// Checks a single signature, which can be stored on the heap. Returns 1 if it matches, 0 otherwise.
+static inline int ecs_component_enum_match_one(ComponentEnum* signature, ComponentEnum* with, ComponentEnum* without, const EcsMatchFilter* filter) {
+    if(ecs_component_enum_is_heap(signature))
+        return ecs_component_enum_contains_enum(signature, with) && ecs_component_enum_not_contains_enum(signature, without);
+
+    return ecs_component_enum_match_inline(signature->bits.words, filter);
+}
+
+int ecs_component_enum_match_many(ComponentEnum* signatures, int count, ComponentEnum* with, ComponentEnum* without, uint64_t* mask) {
+    int matches = 0;
+    for(int i = 0; i < (count + 63) / 64; ++i)
+        mask[i] = 0;
+
+    // Filters with flags past the inline words can only be checked one signature at a time.
+    if(ecs_component_enum_is_heap(with) || ecs_component_enum_is_heap(without)) {
+        for(int i = 0; i < count; ++i) {
+            if(ecs_component_enum_contains_enum(signatures + i, with) && ecs_component_enum_not_contains_enum(signatures + i, without)) {
+                mask[i >> 6] |= (uint64_t)1 << (i & 63);
+                ++matches;
+            }
+        }
+
+        return matches;
+    }
+
+    EcsMatchFilter filter;
+    ecs_memcpy(filter.with, with->bits.words, sizeof(filter.with));
+    ecs_memcpy(filter.without, without->bits.words, sizeof(filter.without));
+
+    int i = 0;
+
+#if defined(ECS_MATCH_AVX2) && ECS_COMPONENT_ENUM_INLINE_WORDS == 4
+    __m128i with_half = _mm_loadu_si128((const __m128i*)filter.with);
+    __m128i without_half = _mm_loadu_si128((const __m128i*)filter.without);
+    __m256i with_pair = _mm256_set_m128i(with_half, with_half);
+    __m256i without_pair = _mm256_set_m128i(without_half, without_half);
+
+    for(; i + 1 < count; i += 2) {
+        uint64_t pair;
+        if(ecs_component_enum_is_heap(signatures + i) || ecs_component_enum_is_heap(signatures + i + 1)) {
+            pair = (uint64_t)ecs_component_enum_match_one(signatures + i, with, without, &filter) |
+                   ((uint64_t)ecs_component_enum_match_one(signatures + i + 1, with, without, &filter) << 1);
+        } else {
+            pair = (uint64_t)ecs_component_enum_match_inline_pair(signatures[i].bits.words, signatures[i + 1].bits.words, with_pair, without_pair);
+        }
+
+        mask[i >> 6] |= pair << (i & 63);
+        matches += (int)(pair & 1) + (int)(pair >> 1);
+    }
+#endif
+
+    for(; i < count; ++i) {
+        uint64_t match = (uint64_t)ecs_component_enum_match_one(signatures + i, with, without, &filter);
+        mask[i >> 6] |= match << (i & 63);
+        matches += (int)match;
+    }
+
+    return matches;
+}
\ No newline at end of file
@@ -0,0 +1,182 @@
+#include "ecs_component_group.h"
+
+struct EcsComponentGroup {
+    EcsWorld world;
+    EcsComponentManager** managers;
+    EcsComponentPool** pools;
+    int count;
+
+    // The number of entities at the front of every pool that own all of the component types.
+    int size;
+
+    // Holds a single component while two components are swapped. Large enough for any of the pools.
+    char* scratch;
+};
+
+// Swaps two components of a pool along with their links and versions.
+// Owned pools never contain shared components, so the mapping of both owners can be updated directly.
+static void component_group_swap(EcsComponentGroup* group, EcsComponentPool* pool, int left, int right) {
+    if(left == right)
+        return;
+
+    ComponentLink link = pool->links[left];
+    pool->links[left] = pool->links[right];
+    pool->links[right] = link;
+
+    char* left_component = ecs_component_pool_at(pool, left);
+    char* right_component = ecs_component_pool_at(pool, right);
+    ecs_memcpy(group->scratch, left_component, pool->component_size);
+    ecs_memcpy(left_component, right_component, pool->component_size);
+    ecs_memcpy(right_component, group->scratch, pool->component_size);
+
+    if(pool->track_changes) {
+        unsigned int version = pool->versions[left];
+        pool->versions[left] = pool->versions[right];
+        pool->versions[right] = version;
+    }
+
+    ecs_sparse_map_set(&pool->mapping, pool->links[left].entity_id, left << 1);
+    ecs_sparse_map_set(&pool->mapping, pool->links[right].entity_id, right << 1);
+}
+
+// Determines if any component of a pool is referenced by more than one entity.
+static bool component_group_pool_has_shares(EcsComponentPool* pool) {
+    for(int i = 0; i <= pool->last_component_index; i++) {
+        if(pool->links[i].share != -1)
+            return true;
+    }
+
+    return false;
+}
+
+EcsComponentGroup* ecs_component_group_init(EcsWorld world, EcsComponentManager** managers, int count) {
+    if(count <= 0)
+        return NULL;
+
+    int scratch_size = 1;
+    for(int i = 0; i < count; i++) {
+        if(managers[i]->storage != ECS_COMPONENT_STORAGE_POOL || managers[i]->chunk_shift != 0)
+            return NULL;
+
+        EcsComponentPool* pool = ecs_component_find_pool(world, managers[i]);
+        if(pool != NULL && (pool->group != NULL || component_group_pool_has_shares(pool)))
+            return NULL;
+
+        for(int j = 0; j < i; j++) {
+            if(managers[j] == managers[i])
+                return NULL;
+        }
+
+        if(managers[i]->component_size > scratch_size)
+            scratch_size = managers[i]->component_size;
+    }
+
+    EcsComponentGroup* group = ecs_malloc(sizeof(EcsComponentGroup));
+    group->world = world;
+    group->managers = ecs_malloc(sizeof(EcsComponentManager*) * count);
+    group->pools = ecs_malloc(sizeof(EcsComponentPool*) * count);
+    group->count = count;
+    group->size = 0;
+    group->scratch = ecs_malloc(scratch_size);
+
+    ecs_memcpy(group->managers, managers, sizeof(EcsComponentManager*) * count);
+
+    // The pools are created up front so that they can't be missed when the first component is added.
+    for(int i = 0; i < count; i++) {
+        group->pools[i] = ecs_component_get_pool(world, managers[i]);
+        group->pools[i]->group = group;
+    }
+
+    // Only the entities of the smallest pool can be in the group.
+    EcsComponentPool* smallest = group->pools[0];
+    for(int i = 1; i < count; i++) {
+        if(group->pools[i]->last_component_index < smallest->last_component_index)
+            smallest = group->pools[i];
+    }
+
+    // Joining the group only moves components that are already in the group or at the current end of it,
+    // so the components past the current index can still be visited in order.
+    for(int i = 0; i <= smallest->last_component_index; i++)
+        ecs_component_group_on_add(group, smallest->links[i].entity_id);
+
+    return group;
+}
+
+void ecs_component_group_free(EcsComponentGroup* group) {
+    ecs_component_group_detach(group);
+
+    ecs_free(group->managers);
+    ecs_free(group->pools);
+    ecs_free(group->scratch);
+    ecs_free(group);
+}
+
+int ecs_component_group_size(EcsComponentGroup* group) {
+    return group->size;
+}
+
+void* ecs_component_group_get_components(EcsComponentGroup* group, EcsComponentManager* manager, int* count) {
+    *count = group->size;
+
+    for(int i = 0; i < group->count; i++) {
+        if(group->managers[i] == manager)
+            return group->pools[i] == NULL ? NULL : group->pools[i]->components;
+    }
+
+    return NULL;
+}
+
+EcsEntity ecs_component_group_get_entity(EcsComponentGroup* group, int index) {
+    EcsEntity entity = { group->world, -1 };
+    if(group->pools[0] != NULL)
+        entity.id = group->pools[0]->links[index].entity_id;
+
+    return entity;
+}
+
+void ecs_component_group_on_add(EcsComponentGroup* group, int entity_id) {
+    // The indices are only gathered on the stack for small groups, which is almost always the case.
+    int stack_indices[8];
+    int* indices = group->count <= 8 ? stack_indices : ecs_malloc(sizeof(int) * group->count);
+
+    bool owns_all = true;
+    for(int i = 0; i < group->count && owns_all; i++) {
+        indices[i] = ecs_component_pool_lookup(group->pools[i], entity_id);
+        owns_all = indices[i] >= group->size;
+    }
+
+    // An index below the size means the entity is already in the group.
+    if(owns_all) {
+        for(int i = 0; i < group->count; i++)
+            component_group_swap(group, group->pools[i], indices[i], group->size);
+
+        group->size++;
+    }
+
+    if(indices != stack_indices)
+        ecs_free(indices);
+}
+
+void ecs_component_group_on_remove(EcsComponentGroup* group, int entity_id) {
+    int index = ecs_component_pool_lookup(group->pools[0], entity_id);
+    if(index == -1 || index >= group->size)
+        return;
+
+    // Swap the entity with the last member of the group in every pool, then shrink the group past it.
+    group->size--;
+    for(int i = 0; i < group->count; i++) {
+        EcsComponentPool* pool = group->pools[i];
+        component_group_swap(group, pool, ecs_component_pool_lookup(pool, entity_id), group->size);
+    }
+}
+
+void ecs_component_group_detach(EcsComponentGroup* group) {
+    for(int i = 0; i < group->count; i++) {
+        if(group->pools[i] != NULL)
+            group->pools[i]->group = NULL;
+
+        group->pools[i] = NULL;
+    }
+
+    group->size = 0;
+}
\ No newline at end of file
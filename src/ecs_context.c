@@ -0,0 +1,49 @@
+#include "ecs_context.h"
+
+#include "ecs_messages.h"
+#include "ecs_world.h"
+#include "ecs_archetype.h"
+#include "ecs_entity_set.h"
+
+EcsContext ___ecs_default_context;
+ECS_THREAD_LOCAL EcsContext* ___ecs_current_context = NULL;
+
+void ecs_context_set_current(EcsContext* context) {
+    ___ecs_current_context = context;
+}
+
+void ecs_context_setup(EcsContext* context) {
+    // The subsystems initialize whichever context is current, so switch to the new one until they're done.
+    EcsContext* previous = ___ecs_current_context;
+    ___ecs_current_context = context;
+
+    context->last_component_flag = 1;
+
+    ecs_messages_init();
+    ecs_world_system_init();
+    ecs_archetype_system_init();
+    ecs_entity_set_system_init();
+
+    ___ecs_current_context = previous;
+}
+
+EcsContext* ecs_context_init(void) {
+    EcsContext* context = ecs_malloc(sizeof(EcsContext));
+    ecs_context_setup(context);
+    return context;
+}
+
+void ecs_context_free(EcsContext* context) {
+    EcsContext* previous = ___ecs_current_context;
+    ___ecs_current_context = context;
+
+    ecs_entity_set_system_free();
+    ecs_archetype_system_free();
+    ecs_world_system_free();
+    ecs_messages_free();
+
+    ___ecs_current_context = previous == context ? NULL : previous;
+
+    if(context != &___ecs_default_context)
+        ecs_free(context);
+}
\ No newline at end of file
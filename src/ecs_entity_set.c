@@ -1,5 +1,7 @@
 #include "ecs_entity_set.h"
 #include "ecs_messages.h"
+#include "ecs_sparse_map.h"
+#include "ecs_archetype.h"
 
 #include <stdio.h>
 
@@ -17,21 +19,36 @@ struct EcsEntitySetBuilder {
 struct EcsEntitySet {
     EcsComponentManager** with_components;
     EcsComponentManager** without_components;
-    int* with_subscriptions;
-    int* without_subscriptions;
-    int* mapping;
+    EcsSparseMap mapping;
     EcsEntity* entities;
     ComponentEnum with;
     ComponentEnum without;
     int with_count;
     int without_count;
-    int mapping_capacity;
     int entity_capacity;
     int last_index;
-    int entity_disabled_subscription;
-    int entity_enabled_subscription;
-    int entity_created_subscription;
     EcsWorld world;
+
+    // Sets built with the same conditions on the same world are shared. The set is only freed
+    // once every build has been matched by a free. The key is the hash of with and without.
+    int references;
+    unsigned int key;
+
+    // In scan mode the event handlers only count changes and mark the set as dirty,
+    // and the entities are rebuilt from the signatures of the world when they're requested.
+    EcsEntitySetMode mode;
+    bool adaptive;
+    bool dirty;
+    int changes;
+
+    // Every owner of a shared set gets its entities once per frame, so a frame only ends after
+    // as many calls as there are references. frame_changes accumulates the changes of every call in it.
+    int frame_calls;
+    int frame_changes;
+
+    // The number of frames in a row the other mode would have been cheaper.
+    int streak;
+    EcsEntitySetStats stats;
 };
 
 EcsEntitySetBuilder* ecs_entity_set_builder_init(void) {
@@ -73,201 +90,663 @@ void ecs_entity_set_without(EcsEntitySetBuilder* builder, EcsComponentManager* m
 }
 
 static void entity_set_add(EcsEntitySet* set, EcsEntity entity) {
-    ECS_ARRAY_RESIZE_DEFAULT(set->mapping, set->mapping_capacity, entity.id, sizeof(int), -1);
-
-    int* index = set->mapping + entity.id;
-    if(*index == -1) {
-        *index = ++set->last_index;
+    if(ecs_sparse_map_get(&set->mapping, entity.id) == -1) {
+        int index = ++set->last_index;
+        ecs_sparse_map_set(&set->mapping, entity.id, index);
 
-        ECS_ARRAY_RESIZE(set->entities, set->entity_capacity, *index, sizeof(EcsEntity));
+        ECS_ARRAY_RESIZE(set->entities, set->entity_capacity, index, sizeof(EcsEntity));
 
-        set->entities[*index] = entity;
+        set->entities[index] = entity;
     }
 }
 
 static void entity_set_remove(EcsEntitySet* set, EcsEntity entity) {
-    if(entity.id >= set->mapping_capacity)
+    int index = ecs_sparse_map_get(&set->mapping, entity.id);
+    if(index == -1)
         return;
 
-    int* index = set->mapping + entity.id;
-    if(*index == -1)
-        return;
-
-    if(*index != set->last_index) {
-        set->entities[*index] = set->entities[set->last_index];
-        set->mapping[set->entities[set->last_index].id] = *index;
+    if(index != set->last_index) {
+        set->entities[index] = set->entities[set->last_index];
+        ecs_sparse_map_set(&set->mapping, set->entities[set->last_index].id, index);
     }
 
     --set->last_index;
-    *index = -1;
+    ecs_sparse_map_remove(&set->mapping, entity.id);
 }
 
 static inline bool entity_set_filter_enum(EcsEntitySet* set, ComponentEnum* cenum) {
     return ecs_component_enum_contains_enum(cenum, &set->with) && ecs_component_enum_not_contains_enum(cenum, &set->without);
 }
 
-static void entity_set_entity_created_add(void* data, EcsEntityCreatedMessage* message) {
-    entity_set_add((EcsEntitySet*)data, message->entity);
+// Records that the set was notified about count changes. Returns true if the set has to be updated right away.
+static inline bool entity_set_count_changes(EcsEntitySet* set, int count) {
+    set->changes += count;
+    set->dirty = true;
+    return set->mode == ECS_ENTITY_SET_MODE_MAINTAINED;
+}
+
+// Updates the membership of an entity in a set whose conditions involve a component that was just added or removed.
+static inline void entity_set_update_entity(EcsEntitySet* set, EcsEntity entity, ComponentEnum* components) {
+    if(!entity_set_count_changes(set, 1))
+        return;
+
+    if(entity_set_filter_enum(set, components))
+        entity_set_add(set, entity);
+    else
+        entity_set_remove(set, entity);
+}
+
+// Instead of every set subscribing to the events of each of its components, the sets of a world are
+// indexed by the component types they use. Each component type is subscribed to once per world,
+// and a change only evaluates the sets that are indexed under that type.
+typedef struct EcsEntitySetIndex {
+    EcsComponentManager* manager;
+    EcsEntitySet** sets;
+    int count;
+    int capacity;
+    int subscriptions[4];
+} EcsEntitySetIndex;
+
+typedef struct EcsEntitySetRegistry {
+    EcsWorld world;
+    EcsEntitySet** sets;
+    int count;
+    int capacity;
+
+    // Indexed by the position of the component flag, see entity_set_flag_ordinal.
+    EcsEntitySetIndex** indices;
+    int index_capacity;
+
+    int entity_created_subscription;
+    int entity_enabled_subscription;
+    int entity_disabled_subscription;
+} EcsEntitySetRegistry;
+
+static int entity_set_flag_ordinal(ComponentFlag flag) {
+    int ordinal = (int)COMPONENT_FLAG_INDEX(flag) * 32;
+    for(unsigned long long bit = COMPONENT_FLAG_BIT(flag); bit > 1; bit >>= 1)
+        ordinal++;
+
+    return ordinal;
+}
+
+static void entity_set_index_component_changed(EcsEntitySetIndex* index, EcsEntity entity) {
+    ComponentEnum* components = ecs_entity_get_components(entity);
+    for(int i = 0; i < index->count; ++i)
+        entity_set_update_entity(index->sets[i], entity, components);
+}
+
+static void entity_set_index_component_changed_many(EcsEntitySetIndex* index, EcsWorld world, EcsEntity* entities, int count) {
+    int entity_count;
+    ComponentEnum* components = ecs_world_get_components(world, &entity_count);
+
+    for(int i = 0; i < index->count; ++i) {
+        EcsEntitySet* set = index->sets[i];
+        if(!entity_set_count_changes(set, count))
+            continue;
+
+        ECS_ARRAY_RESIZE(set->entities, set->entity_capacity, set->last_index + count, sizeof(EcsEntity));
+
+        for(int j = 0; j < count; ++j) {
+            if(entity_set_filter_enum(set, components + entities[j].id))
+                entity_set_add(set, entities[j]);
+            else
+                entity_set_remove(set, entities[j]);
+        }
+    }
+}
+
+static void entity_set_index_component_added(void* data, EcsComponentAddedMessage* message) {
+    entity_set_index_component_changed(data, message->entity);
+}
+
+static void entity_set_index_component_removed(void* data, EcsComponentRemovedMessage* message) {
+    entity_set_index_component_changed(data, message->entity);
+}
+
+static void entity_set_index_component_added_many(void* data, EcsComponentAddedManyMessage* message) {
+    if(message->count != 0)
+        entity_set_index_component_changed_many(data, message->entities[0].world, message->entities, message->count);
+}
+
+static void entity_set_index_component_removed_many(void* data, EcsComponentRemovedManyMessage* message) {
+    if(message->count != 0)
+        entity_set_index_component_changed_many(data, message->entities[0].world, message->entities, message->count);
+}
+
+static void entity_set_registry_entity_created(void* data, EcsEntityCreatedMessage* message) {
+    EcsEntitySetRegistry* registry = data;
+
+    // A new entity doesn't have any components yet, so it only belongs to the sets that don't require any.
+    for(int i = 0; i < registry->count; ++i) {
+        EcsEntitySet* set = registry->sets[i];
+        if(set->with_count == 0 && entity_set_count_changes(set, 1))
+            entity_set_add(set, message->entity);
+    }
+}
+
+static void entity_set_registry_entity_enabled(void* data, EcsEntityEnabledMessage* message) {
+    EcsEntitySetRegistry* registry = data;
+    ComponentEnum* components = ecs_entity_get_components(message->entity);
+
+    for(int i = 0; i < registry->count; ++i) {
+        EcsEntitySet* set = registry->sets[i];
+        if(entity_set_count_changes(set, 1) && entity_set_filter_enum(set, components))
+            entity_set_add(set, message->entity);
+    }
+}
+
+static void entity_set_registry_entity_disabled(void* data, EcsEntityDisabledMessage* message) {
+    EcsEntitySetRegistry* registry = data;
+
+    for(int i = 0; i < registry->count; ++i) {
+        EcsEntitySet* set = registry->sets[i];
+        if(entity_set_count_changes(set, 1))
+            entity_set_remove(set, message->entity);
+    }
+}
+
+static EcsEntitySetRegistry* entity_set_registry_get(EcsWorld world) {
+    EcsContext* context = ecs_context_get_current();
+    if(world >= context->entity_set_registry_capacity)
+        return NULL;
+
+    return context->entity_set_registries[world];
+}
+
+static EcsEntitySetRegistry* entity_set_registry_get_or_create(EcsWorld world) {
+    EcsEntitySetRegistry* registry = entity_set_registry_get(world);
+    if(registry != NULL)
+        return registry;
+
+    EcsContext* context = ecs_context_get_current();
+    ECS_ARRAY_RESIZE_DEFAULT(context->entity_set_registries, context->entity_set_registry_capacity, world, sizeof(EcsEntitySetRegistry*), NULL);
+
+    registry = ecs_malloc(sizeof(EcsEntitySetRegistry));
+    registry->world = world;
+    registry->sets = NULL;
+    registry->count = 0;
+    registry->capacity = 0;
+    registry->indices = NULL;
+    registry->index_capacity = 0;
+    registry->entity_created_subscription = ecs_event_subscribe(world, ecs_entity_created, ecs_closure(registry, entity_set_registry_entity_created));
+    registry->entity_enabled_subscription = ecs_event_subscribe(world, ecs_entity_enabled, ecs_closure(registry, entity_set_registry_entity_enabled));
+    registry->entity_disabled_subscription = ecs_event_subscribe(world, ecs_entity_disabled, ecs_closure(registry, entity_set_registry_entity_disabled));
+
+    context->entity_set_registries[world] = registry;
+    return registry;
+}
+
+static void entity_set_registry_free(EcsEntitySetRegistry* registry) {
+    for(int i = 0; i < registry->index_capacity; ++i) {
+        if(registry->indices[i] != NULL) {
+            ecs_free(registry->indices[i]->sets);
+            ecs_free(registry->indices[i]);
+        }
+    }
+
+    ecs_free(registry->indices);
+    ecs_free(registry->sets);
+    ecs_free(registry);
+}
+
+static bool entity_set_list_contains(EcsEntitySet** sets, int count, EcsEntitySet* set) {
+    for(int i = 0; i < count; ++i) {
+        if(sets[i] == set)
+            return true;
+    }
+
+    return false;
+}
+
+static void entity_set_list_remove(EcsEntitySet** sets, int* count, EcsEntitySet* set) {
+    for(int i = 0; i < *count; ++i) {
+        if(sets[i] == set) {
+            // Keep the order so that sets are always updated in the order they were built.
+            ecs_memmove(sets + i, sets + i + 1, sizeof(EcsEntitySet*) * (*count - i - 1));
+            --*count;
+            return;
+        }
+    }
 }
 
-static void entity_set_entity_enabled_checked_add(void* data, EcsEntityEnabledMessage* message) {
-    EcsEntitySet* set = data;
-    if(entity_set_filter_enum(set, ecs_entity_get_components(message->entity)))
-        entity_set_add(set, message->entity);
+static void entity_set_registry_index(EcsEntitySetRegistry* registry, EcsEntitySet* set, EcsComponentManager* manager) {
+    int ordinal = entity_set_flag_ordinal(manager->flag);
+    ECS_ARRAY_RESIZE_DEFAULT(registry->indices, registry->index_capacity, ordinal, sizeof(EcsEntitySetIndex*), NULL);
+
+    EcsEntitySetIndex* index = registry->indices[ordinal];
+    if(index == NULL) {
+        EcsWorld world = registry->world;
+        index = ecs_malloc(sizeof(EcsEntitySetIndex));
+        index->manager = manager;
+        index->sets = NULL;
+        index->count = 0;
+        index->capacity = 0;
+        index->subscriptions[0] = ecs_event_subscribe(world, ecs_component_get_added_event(manager), ecs_closure(index, entity_set_index_component_added));
+        index->subscriptions[1] = ecs_event_subscribe(world, ecs_component_get_removed_event(manager), ecs_closure(index, entity_set_index_component_removed));
+        index->subscriptions[2] = ecs_event_subscribe(world, ecs_component_get_added_many_event(manager), ecs_closure(index, entity_set_index_component_added_many));
+        index->subscriptions[3] = ecs_event_subscribe(world, ecs_component_get_removed_many_event(manager), ecs_closure(index, entity_set_index_component_removed_many));
+        registry->indices[ordinal] = index;
+    }
+
+    // A component can be both required and excluded, but the set only has to be checked once.
+    if(entity_set_list_contains(index->sets, index->count, set))
+        return;
+
+    ECS_ARRAY_RESIZE(index->sets, index->capacity, index->count, sizeof(EcsEntitySet*));
+    index->sets[index->count++] = set;
 }
 
-static void entity_set_component_added_checked_add(void* data, EcsComponentAddedMessage* message) {
-    EcsEntitySet* set = data;
-    if(entity_set_filter_enum(set, ecs_entity_get_components(message->entity)))
-        entity_set_add(set, message->entity);
+static void entity_set_registry_unindex(EcsEntitySetRegistry* registry, EcsEntitySet* set, EcsComponentManager* manager) {
+    int ordinal = entity_set_flag_ordinal(manager->flag);
+    if(ordinal >= registry->index_capacity || registry->indices[ordinal] == NULL)
+        return;
+
+    EcsEntitySetIndex* index = registry->indices[ordinal];
+    entity_set_list_remove(index->sets, &index->count, set);
+    if(index->count != 0)
+        return;
+
+    // Stop listening to the component type once no set uses it.
+    EcsWorld world = registry->world;
+    ecs_event_unsubscribe(world, ecs_component_get_added_event(manager), index->subscriptions[0]);
+    ecs_event_unsubscribe(world, ecs_component_get_removed_event(manager), index->subscriptions[1]);
+    ecs_event_unsubscribe(world, ecs_component_get_added_many_event(manager), index->subscriptions[2]);
+    ecs_event_unsubscribe(world, ecs_component_get_removed_many_event(manager), index->subscriptions[3]);
+
+    ecs_free(index->sets);
+    ecs_free(index);
+    registry->indices[ordinal] = NULL;
 }
 
-static void entity_set_component_removed_checked_add(void* data, EcsComponentRemovedMessage* message) {
-    EcsEntitySet* set = data;
-    if(entity_set_filter_enum(set, ecs_entity_get_components(message->entity)))
-        entity_set_add(set, message->entity);
+static void entity_set_register(EcsEntitySet* set) {
+    EcsEntitySetRegistry* registry = entity_set_registry_get_or_create(set->world);
+
+    ECS_ARRAY_RESIZE(registry->sets, registry->capacity, registry->count, sizeof(EcsEntitySet*));
+    registry->sets[registry->count++] = set;
+
+    for(int i = 0; i < set->with_count; i++)
+        entity_set_registry_index(registry, set, set->with_components[i]);
+
+    for(int i = 0; i < set->without_count; i++)
+        entity_set_registry_index(registry, set, set->without_components[i]);
 }
 
-static void entity_set_entity_disposed_remove(void* data, EcsEntityDisposedMessage* message) {
-    entity_set_remove((EcsEntitySet*)data, message->entity);
+static void entity_set_unregister(EcsEntitySet* set) {
+    // The registry is gone if the world was freed before the set.
+    EcsEntitySetRegistry* registry = entity_set_registry_get(set->world);
+    if(registry == NULL || !entity_set_list_contains(registry->sets, registry->count, set))
+        return;
+
+    entity_set_list_remove(registry->sets, &registry->count, set);
+
+    for(int i = 0; i < set->with_count; i++)
+        entity_set_registry_unindex(registry, set, set->with_components[i]);
+
+    for(int i = 0; i < set->without_count; i++)
+        entity_set_registry_unindex(registry, set, set->without_components[i]);
 }
 
-static void entity_set_entity_disabled_remove(void* data, EcsEntityDisabledMessage* message) {
-    entity_set_remove((EcsEntitySet*)data, message->entity);
+static void entity_set_on_world_disposed(void* data, EcsWorldDisposedMessage* message) {
+    EcsContext* context = data;
+    if(message->world < context->entity_set_registry_capacity && context->entity_set_registries[message->world] != NULL) {
+        // The events the registry subscribed to are freed along with the world.
+        entity_set_registry_free(context->entity_set_registries[message->world]);
+        context->entity_set_registries[message->world] = NULL;
+    }
 }
 
-static void entity_set_component_added_remove(void* data, EcsComponentAddedMessage* message) {
-    entity_set_remove((EcsEntitySet*)data, message->entity);
+void ecs_entity_set_system_init(void) {
+    EcsContext* context = ecs_context_get_current();
+    context->entity_set_registries = NULL;
+    context->entity_set_registry_capacity = 0;
+    ecs_event_add(ecs_world_disposed, ecs_closure(context, entity_set_on_world_disposed));
 }
 
-static void entity_set_component_removed_remove(void* data, EcsComponentRemovedMessage* message) {
-    entity_set_remove((EcsEntitySet*)data, message->entity);
+void ecs_entity_set_system_free(void) {
+    EcsContext* context = ecs_context_get_current();
+    for(int i = 0; i < context->entity_set_registry_capacity; ++i) {
+        if(context->entity_set_registries[i] != NULL)
+            entity_set_registry_free(context->entity_set_registries[i]);
+    }
+
+    ecs_free(context->entity_set_registries);
+    context->entity_set_registries = NULL;
+    context->entity_set_registry_capacity = 0;
+}
+
+// Rebuilds the entities of a set from the signatures of every entity in the world.
+// The mapping is only filled if map is true, because scan mode never looks up entities.
+// Returns the number of signatures that were scanned.
+static int entity_set_scan(EcsEntitySet* set, bool map) {
+    int entity_count;
+    ComponentEnum* components = ecs_world_get_components(set->world, &entity_count);
+
+    if(map) {
+        ecs_sparse_map_free_resources(&set->mapping);
+        ecs_sparse_map_init(&set->mapping);
+    }
+    set->last_index = -1;
+
+    // The entities are matched in blocks so the mask can live on the stack.
+    uint64_t mask[16];
+    for(int start = 0; start < entity_count; start += 64 * 16) {
+        int block = entity_count - start < 64 * 16 ? entity_count - start : 64 * 16;
+        int matched = ecs_component_enum_match_many(components + start, block, &set->with, &set->without, mask);
+        if(matched == 0)
+            continue;
+
+        ECS_ARRAY_RESIZE(set->entities, set->entity_capacity, set->last_index + matched, sizeof(EcsEntity));
+
+        for(int word = 0; word < (block + 63) / 64; word++) {
+            for(uint64_t bits = mask[word]; bits != 0; bits &= bits - 1) {
+                EcsEntity entity = { set->world, start + word * 64 + ecs_bit_scan_forward64(bits) };
+                if(map)
+                    entity_set_add(set, entity);
+                else
+                    set->entities[++set->last_index] = entity;
+            }
+        }
+    }
+
+    set->dirty = false;
+    return entity_count;
+}
+
+// Rebuilds the entities and the mapping of a set. Only the entities that own the component of the smallest
+// pool in the with conditions can be in the set, so those are the only ones checked when such a pool exists.
+// Otherwise every signature in the world is scanned. Returns the number of signatures that were checked.
+static int entity_set_fill(EcsEntitySet* set) {
+    EcsComponentPool* smallest = NULL;
+    bool seeded = false;
+    bool empty = false;
+    for(int i = 0; i < set->with_count; i++) {
+        EcsComponentManager* manager = set->with_components[i];
+        if(manager->storage != ECS_COMPONENT_STORAGE_POOL)
+            continue;
+
+        seeded = true;
+        EcsComponentPool* pool = ecs_component_find_pool(set->world, manager);
+        if(pool == NULL) {
+            // Nothing on the world owns the component yet, so nothing can be in the set.
+            empty = true;
+            break;
+        }
+
+        if(smallest == NULL || pool->last_component_index < smallest->last_component_index)
+            smallest = pool;
+    }
+
+    if(!seeded)
+        return entity_set_scan(set, true);
+
+    ecs_sparse_map_free_resources(&set->mapping);
+    ecs_sparse_map_init(&set->mapping);
+    set->last_index = -1;
+    set->dirty = false;
+
+    if(empty)
+        return 0;
+
+    int entity_count;
+    ComponentEnum* components = ecs_world_get_components(set->world, &entity_count);
+    int checked = 0;
+
+    for(int i = 0; i <= smallest->last_component_index; i++) {
+        ComponentLink* link = smallest->links + i;
+        int entity_id = link->entity_id;
+
+        // A shared component is owned by every entity in its sharer ring.
+        do {
+            checked++;
+            if(entity_set_filter_enum(set, components + entity_id)) {
+                EcsEntity entity = { set->world, entity_id };
+                entity_set_add(set, entity);
+            }
+
+            entity_id = link->share == -1 ? link->entity_id : ecs_sparse_map_get(&smallest->share_next, entity_id);
+        } while(entity_id != link->entity_id);
+    }
+
+    return checked;
+}
+
+static void entity_set_switch_mode(EcsEntitySet* set, EcsEntitySetMode mode) {
+    if(set->mode == mode)
+        return;
+
+    set->mode = mode;
+    set->streak = 0;
+    set->stats.switches++;
+
+    // The mapping isn't updated in scan mode, so it has to be rebuilt before the set can be maintained again.
+    // Going the other way, the entities are rescanned the next time they're requested.
+    if(mode == ECS_ENTITY_SET_MODE_MAINTAINED)
+        set->stats.scanned += entity_set_fill(set);
+    else
+        set->dirty = true;
+}
+
+// Compares the cost of the changes since the last frame against the cost of scanning the world,
+// and switches to the cheaper mode once it has been cheaper for enough frames in a row.
+static void entity_set_adapt(EcsEntitySet* set) {
+    int entity_count;
+    ecs_world_get_components(set->world, &entity_count);
+
+    long long change_cost = (long long)set->frame_changes * ECS_ENTITY_SET_CHANGE_COST;
+    long long scan_cost = entity_count;
+
+    // Switching back requires a clear margin so that a set close to the threshold doesn't keep rebuilding its mapping.
+    bool other_cheaper = set->mode == ECS_ENTITY_SET_MODE_MAINTAINED ? change_cost > scan_cost : change_cost * 2 < scan_cost;
+
+    set->streak = other_cheaper ? set->streak + 1 : 0;
+    if(set->streak >= ECS_ENTITY_SET_ADAPT_FRAMES)
+        entity_set_switch_mode(set, set->mode == ECS_ENTITY_SET_MODE_MAINTAINED ? ECS_ENTITY_SET_MODE_SCAN : ECS_ENTITY_SET_MODE_MAINTAINED);
+}
+
+static unsigned int entity_set_key(ComponentEnum* with, ComponentEnum* without) {
+    return ecs_component_enum_hash(with) * 31u + ecs_component_enum_hash(without);
+}
+
+// Finds a set of the world with the same conditions. with must already include the alive and enabled flags.
+static EcsEntitySet* entity_set_find_shared(EcsWorld world, ComponentEnum* with, ComponentEnum* without, unsigned int key) {
+    EcsEntitySetRegistry* registry = entity_set_registry_get(world);
+    if(registry == NULL)
+        return NULL;
+
+    for(int i = 0; i < registry->count; ++i) {
+        EcsEntitySet* set = registry->sets[i];
+        if(set->key == key && ecs_component_enum_equals(&set->with, with) && ecs_component_enum_equals(&set->without, without))
+            return set;
+    }
+
+    return NULL;
 }
 
 EcsEntitySet* ecs_entity_set_build(EcsEntitySetBuilder* builder, EcsWorld world, bool free_builder) {
+    ComponentEnum with = ecs_component_enum_copy(&builder->with);
+    ecs_component_enum_set_flag(&with, ecs_is_alive_flag, true);
+    ecs_component_enum_set_flag(&with, ecs_is_enabled_flag, true);
+
+    unsigned int key = entity_set_key(&with, &builder->without);
+    EcsEntitySet* shared = entity_set_find_shared(world, &with, &builder->without, key);
+    if(shared != NULL) {
+        ecs_component_enum_free_resources(&with);
+        if(free_builder)
+            ecs_entity_set_builder_free(builder);
+
+        shared->references++;
+        return shared;
+    }
+
     EcsEntitySet* set = ecs_malloc(sizeof(EcsEntitySet));
 
     set->with_count = builder->with_count;
     set->without_count = builder->without_count;
 
-    set->mapping = NULL;
-    set->mapping_capacity = 0;
+    ecs_sparse_map_init(&set->mapping);
     set->entities = NULL;
     set->entity_capacity = 0;
     set->last_index = -1;
     set->world = world;
+    set->references = 1;
+    set->key = key;
+    set->with = with;
+    set->mode = ECS_ENTITY_SET_MODE_MAINTAINED;
+    set->adaptive = true;
+    set->dirty = false;
+    set->changes = 0;
+    set->frame_calls = 0;
+    set->frame_changes = 0;
+    set->streak = 0;
+    set->stats = (EcsEntitySetStats){ ECS_ENTITY_SET_MODE_MAINTAINED, true, 0, 0, 0 };
 
     if(free_builder) {
         set->with_components = builder->with_components;
         set->without_components = builder->without_components;
-        set->with = builder->with;
         set->without = builder->without;
 
+        ecs_component_enum_free_resources(&builder->with);
         ecs_free(builder);
     } else {
         set->with_components = malloc(sizeof(EcsComponentManager*) * builder->with_count);
         set->without_components = malloc(sizeof(EcsComponentManager*) * builder->without_count);
         ecs_memcpy(set->with_components, builder->with_components, sizeof(EcsComponentManager*) * builder->with_count);
         ecs_memcpy(set->without_components, builder->without_components, sizeof(EcsComponentManager*) * builder->without_count);
-        set->with = ecs_component_enum_copy(&builder->with);
         set->without = ecs_component_enum_copy(&builder->without);
     }
 
-    ecs_component_enum_set_flag(&set->with, ecs_is_alive_flag, true);
-    ecs_component_enum_set_flag(&set->with, ecs_is_enabled_flag, true);
+    entity_set_register(set);
 
-    set->entity_disabled_subscription = ecs_event_subscribe(world,
-                                                            ecs_entity_disabled,
-                                                            ecs_closure(set, entity_set_entity_disabled_remove));
+    // Fill the set with existing components that match the component conditions.
+    entity_set_fill(set);
 
-    set->entity_enabled_subscription = ecs_event_subscribe(world,
-                                                           ecs_entity_enabled,
-                                                           ecs_closure(set, entity_set_entity_enabled_checked_add));
+    return set;
+}
 
-    if(set->with_count == 0) {
-        set->entity_created_subscription = ecs_event_subscribe(world,
-                                                               ecs_entity_created,
-                                                               ecs_closure(set, entity_set_entity_created_add));
-    }
+void ecs_entity_set_free(EcsEntitySet* set) {
+    if(--set->references > 0)
+        return;
 
-    set->with_subscriptions = malloc(sizeof(int) * set->with_count * 2);
-    set->without_subscriptions = malloc(sizeof(int) * set->without_count * 2);
+    entity_set_unregister(set);
 
-    for(int i = 0; i < set->with_count; i++) {
-        set->with_subscriptions[i * 2] = ecs_event_subscribe(world,
-                                                             ecs_component_get_added_event(set->with_components[i]), 
-                                                             ecs_closure(set, entity_set_component_added_checked_add));
+    ecs_free(set->with_components);
+    ecs_free(set->without_components);
 
-        set->with_subscriptions[i * 2 + 1] = ecs_event_subscribe(world,
-                                                                 ecs_component_get_removed_event(set->with_components[i]),
-                                                                 ecs_closure(set, entity_set_component_removed_remove));
-    }
+    ecs_component_enum_free_resources(&set->with);
+    ecs_component_enum_free_resources(&set->without);
+
+    ecs_sparse_map_free_resources(&set->mapping);
+    ecs_free(set->entities);
 
-    for(int i = 0; i < set->without_count; i++) {
-        set->without_subscriptions[i * 2] = ecs_event_subscribe(world,
-                                                                ecs_component_get_removed_event(set->without_components[i]),
-                                                                ecs_closure(set, entity_set_component_removed_checked_add));
+    ecs_free(set);
+}
 
-        set->without_subscriptions[i * 2 + 1] = ecs_event_subscribe(world,
-                                                                    ecs_component_get_added_event(set->without_components[i]),
-                                                                    ecs_closure(set, entity_set_component_added_remove));
+EcsEntity* ecs_entity_set_get_entities(EcsEntitySet* set, int* count) {
+    set->stats.scanned = 0;
+    set->frame_changes += set->changes;
+    set->changes = 0;
+    set->stats.changes = set->frame_changes;
+
+    // Counting every call as a frame would make the owners after the first one look quiet,
+    // so a shared set is only adapted once every owner got its entities.
+    if(++set->frame_calls >= set->references) {
+        if(set->adaptive)
+            entity_set_adapt(set);
+
+        set->frame_calls = 0;
+        set->frame_changes = 0;
     }
 
-    // Fill the set with existing components that match the component conditions.
-    int entity_count;
-    ComponentEnum* components = ecs_world_get_components(world, &entity_count);
+    if(set->mode == ECS_ENTITY_SET_MODE_SCAN && set->dirty)
+        set->stats.scanned += entity_set_scan(set, false);
 
-    for(int i = 0; i < entity_count; i++, components++) {
-        if(entity_set_filter_enum(set, components))
-            entity_set_add(set, (EcsEntity){ .world = world, .id = i });
-    }
+    *count = set->last_index + 1;
+    return set->entities;
+}
 
-    return set;
+void ecs_entity_set_set_mode(EcsEntitySet* set, EcsEntitySetMode mode, bool adaptive) {
+    set->adaptive = adaptive;
+    set->streak = 0;
+    entity_set_switch_mode(set, mode);
 }
 
-void ecs_entity_set_free(EcsEntitySet* set) {
-    for(int i = 0; i < set->with_count; i++) {
-        ecs_event_unsubscribe(set->world, 
-                              ecs_component_get_added_event(set->with_components[i]), 
-                              set->with_subscriptions[i * 2]);
+EcsEntitySetStats ecs_entity_set_get_stats(EcsEntitySet* set) {
+    EcsEntitySetStats stats = set->stats;
+    stats.mode = set->mode;
+    stats.adaptive = set->adaptive;
+    return stats;
+}
 
-        ecs_event_unsubscribe(set->world,
-                              ecs_component_get_removed_event(set->with_components[i]),
-                              set->with_subscriptions[i * 2 + 1]);
+// Fills components with the component of each manager owned by the entity.
+// Pool storage uses the pools that were looked up once by the caller.
+static inline void entity_set_resolve(EcsEntity entity, EcsComponentManager** managers, EcsComponentPool** pools, int manager_count, void** components, int stride) {
+    for(int i = 0; i < manager_count; ++i) {
+        void* component = NULL;
+        if(pools[i] != NULL) {
+            int index = ecs_component_pool_lookup(pools[i], entity.id);
+            if(index != -1)
+                component = ecs_component_pool_at(pools[i], index);
+        } else if(managers[i]->storage == ECS_COMPONENT_STORAGE_ARCHETYPE) {
+            component = ecs_archetype_get(entity, managers[i]);
+        }
+
+        components[i * stride] = component;
     }
+}
+
+// Looks up the pool of each manager on the world. Returns NULL if there are no managers.
+static EcsComponentPool** entity_set_find_pools(EcsWorld world, EcsComponentManager** managers, int manager_count) {
+    if(manager_count == 0)
+        return NULL;
 
-    for(int i = 0; i < set->without_count; i++) {
-        ecs_event_unsubscribe(set->world,
-                              ecs_component_get_removed_event(set->without_components[i]),
-                              set->without_subscriptions[i * 2]);
+    EcsComponentPool** pools = ecs_malloc(sizeof(EcsComponentPool*) * manager_count);
+    for(int i = 0; i < manager_count; ++i)
+        pools[i] = ecs_component_find_pool(world, managers[i]);
 
-        ecs_event_unsubscribe(set->world,
-                              ecs_component_get_added_event(set->without_components[i]),
-                              set->without_subscriptions[i * 2 + 1]);
+    return pools;
+}
+
+void ecs_entity_set_each(EcsEntitySet* set, EcsComponentManager** managers, int manager_count, EcsEntitySetEachFunction fn, void* data) {
+    int count;
+    EcsEntity* entities = ecs_entity_set_get_entities(set, &count);
+    if(count == 0)
+        return;
+
+    EcsComponentPool** pools = entity_set_find_pools(set->world, managers, manager_count);
+    void** components = manager_count == 0 ? NULL : ecs_malloc(sizeof(void*) * manager_count);
+
+    for(int i = 0; i < count; ++i) {
+        entity_set_resolve(entities[i], managers, pools, manager_count, components, 1);
+        fn(data, entities[i], components);
     }
 
-    ecs_free(set->with_subscriptions);
-    ecs_free(set->without_subscriptions);
+    ecs_free(components);
+    ecs_free(pools);
+}
 
-    if(set->with_count == 0)
-        ecs_event_unsubscribe(set->world,  ecs_entity_created, set->entity_created_subscription);
+void ecs_entity_set_each_batch(EcsEntitySet* set, EcsComponentManager** managers, int manager_count, int batch_size, EcsEntitySetEachBatchFunction fn, void* data) {
+    int count;
+    EcsEntity* entities = ecs_entity_set_get_entities(set, &count);
+    if(count == 0)
+        return;
 
-    ecs_event_unsubscribe(set->world, ecs_entity_enabled, set->entity_enabled_subscription);
-    ecs_event_unsubscribe(set->world, ecs_entity_disabled, set->entity_disabled_subscription);
+    if(batch_size < 1 || batch_size > count)
+        batch_size = count;
 
-    ecs_free(set->with_components);
-    ecs_free(set->without_components);
+    EcsComponentPool** pools = entity_set_find_pools(set->world, managers, manager_count);
+    void** components = manager_count == 0 ? NULL : ecs_malloc(sizeof(void*) * manager_count * batch_size);
 
-    ecs_component_enum_free_resources(&set->with);
-    ecs_component_enum_free_resources(&set->without);
+    for(int start = 0; start < count; start += batch_size) {
+        int batch = count - start < batch_size ? count - start : batch_size;
 
-    ecs_free(set->mapping);
-    ecs_free(set->entities);
+        // Each component type gets its own column so the function can walk a single type at a time.
+        for(int i = 0; i < batch; ++i)
+            entity_set_resolve(entities[start + i], managers, pools, manager_count, components + i, batch);
 
-    ecs_free(set);
-}
+        fn(data, entities + start, components, batch);
+    }
 
-EcsEntity* ecs_entity_set_get_entities(EcsEntitySet* set, int* count) {
-    *count = set->last_index + 1;
-    return set->entities;
+    ecs_free(components);
+    ecs_free(pools);
 }
\ No newline at end of file
@@ -0,0 +1,275 @@
+#include "ecs_job.h"
+
+#include "ecs_context.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+
+typedef HANDLE EcsThread;
+typedef CRITICAL_SECTION EcsMutex;
+typedef CONDITION_VARIABLE EcsCondition;
+
+#define ecs_mutex_init(mutex) InitializeCriticalSection(mutex)
+#define ecs_mutex_free(mutex) DeleteCriticalSection(mutex)
+#define ecs_mutex_lock(mutex) EnterCriticalSection(mutex)
+#define ecs_mutex_unlock(mutex) LeaveCriticalSection(mutex)
+#define ecs_condition_init(condition) InitializeConditionVariable(condition)
+#define ecs_condition_free(condition)
+#define ecs_condition_wait(condition, mutex) SleepConditionVariableCS(condition, mutex, INFINITE)
+#define ecs_condition_signal(condition) WakeConditionVariable(condition)
+#define ecs_condition_broadcast(condition) WakeAllConditionVariable(condition)
+
+// Returns the value before the increment.
+#define ecs_atomic_fetch_increment(value) (InterlockedIncrement(value) - 1)
+#else
+#include <pthread.h>
+#include <unistd.h>
+
+typedef pthread_t EcsThread;
+typedef pthread_mutex_t EcsMutex;
+typedef pthread_cond_t EcsCondition;
+
+#define ecs_mutex_init(mutex) pthread_mutex_init(mutex, NULL)
+#define ecs_mutex_free(mutex) pthread_mutex_destroy(mutex)
+#define ecs_mutex_lock(mutex) pthread_mutex_lock(mutex)
+#define ecs_mutex_unlock(mutex) pthread_mutex_unlock(mutex)
+#define ecs_condition_init(condition) pthread_cond_init(condition, NULL)
+#define ecs_condition_free(condition) pthread_cond_destroy(condition)
+#define ecs_condition_wait(condition, mutex) pthread_cond_wait(condition, mutex)
+#define ecs_condition_signal(condition) pthread_cond_signal(condition)
+#define ecs_condition_broadcast(condition) pthread_cond_broadcast(condition)
+
+#define ecs_atomic_fetch_increment(value) __atomic_fetch_add(value, 1, __ATOMIC_RELAXED)
+#endif
+
+// The chunks owned by a single thread. Other threads steal from the same counter once they run out of their own chunks.
+typedef struct EcsJobRange {
+    volatile long next;
+    long end;
+
+    // Keeps the counters of different threads on separate cache lines.
+    char padding[64 - sizeof(long) * 2];
+} EcsJobRange;
+
+typedef struct EcsJobWorker {
+    EcsJobPool* pool;
+    EcsThread thread;
+    int index;
+} EcsJobWorker;
+
+struct EcsJobPool {
+    EcsJobWorker* workers;
+    int thread_count;
+
+    EcsMutex mutex;
+    EcsCondition work_available;
+    EcsCondition work_finished;
+
+    // Incremented every time a loop is started, so the workers can tell a new loop from a spurious wakeup.
+    unsigned int generation;
+    int working;
+    bool shutdown;
+
+    // Set while a loop is running, so that a loop started from inside of a job runs on the thread that started it.
+    bool running;
+
+    // The loop that is currently running.
+    EcsJobFunction function;
+    void* data;
+    int count;
+    int grain_size;
+    EcsContext* context;
+    EcsJobRange* ranges;
+};
+
+static ECS_THREAD_LOCAL int ecs_job_worker_index = 0;
+
+int ecs_job_get_worker_index(void) {
+    return ecs_job_worker_index;
+}
+
+static void ecs_job_pool_run_chunk(EcsJobPool* pool, long chunk) {
+    int start = (int)(chunk * pool->grain_size);
+    int end = pool->count - start < pool->grain_size ? pool->count : start + pool->grain_size;
+    pool->function(pool->data, start, end);
+}
+
+// Processes the chunks owned by a thread, then steals from the other threads until every chunk has been claimed.
+static void ecs_job_pool_participate(EcsJobPool* pool, int index) {
+    int participants = pool->thread_count + 1;
+    for(int i = 0; i < participants; ++i) {
+        EcsJobRange* range = pool->ranges + (index + i) % participants;
+        long chunk;
+        while((chunk = ecs_atomic_fetch_increment(&range->next)) < range->end)
+            ecs_job_pool_run_chunk(pool, chunk);
+    }
+}
+
+#if defined(_WIN32)
+static DWORD WINAPI ecs_job_worker_main(LPVOID arg) {
+#else
+static void* ecs_job_worker_main(void* arg) {
+#endif
+    EcsJobWorker* worker = arg;
+    EcsJobPool* pool = worker->pool;
+    unsigned int generation = 0;
+
+    ecs_job_worker_index = worker->index;
+
+    ecs_mutex_lock(&pool->mutex);
+    while(true) {
+        while(!pool->shutdown && pool->generation == generation)
+            ecs_condition_wait(&pool->work_available, &pool->mutex);
+
+        if(pool->shutdown)
+            break;
+
+        generation = pool->generation;
+        ecs_mutex_unlock(&pool->mutex);
+
+        ecs_context_set_current(pool->context);
+        ecs_job_pool_participate(pool, worker->index);
+
+        ecs_mutex_lock(&pool->mutex);
+        if(--pool->working == 0)
+            ecs_condition_signal(&pool->work_finished);
+    }
+    ecs_mutex_unlock(&pool->mutex);
+
+    return 0;
+}
+
+static int ecs_job_default_thread_count(void) {
+#if defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    int cores = (int)info.dwNumberOfProcessors;
+#else
+    int cores = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    return cores > 1 ? cores - 1 : 0;
+}
+
+static void ecs_job_pool_stop(EcsJobPool* pool) {
+    ecs_mutex_lock(&pool->mutex);
+    pool->shutdown = true;
+    ecs_condition_broadcast(&pool->work_available);
+    ecs_mutex_unlock(&pool->mutex);
+
+    for(int i = 0; i < pool->thread_count; ++i) {
+#if defined(_WIN32)
+        WaitForSingleObject(pool->workers[i].thread, INFINITE);
+        CloseHandle(pool->workers[i].thread);
+#else
+        pthread_join(pool->workers[i].thread, NULL);
+#endif
+    }
+}
+
+EcsJobPool* ecs_job_pool_init(int thread_count) {
+    if(thread_count <= 0)
+        thread_count = ecs_job_default_thread_count();
+
+    EcsJobPool* pool = ecs_malloc(sizeof(EcsJobPool));
+    pool->thread_count = thread_count;
+    pool->workers = thread_count == 0 ? NULL : ecs_malloc(sizeof(EcsJobWorker) * thread_count);
+    pool->ranges = ecs_malloc(sizeof(EcsJobRange) * (thread_count + 1));
+    pool->generation = 0;
+    pool->working = 0;
+    pool->shutdown = false;
+    pool->running = false;
+    pool->function = NULL;
+    pool->data = NULL;
+    pool->count = 0;
+    pool->grain_size = 1;
+    pool->context = NULL;
+
+    ecs_mutex_init(&pool->mutex);
+    ecs_condition_init(&pool->work_available);
+    ecs_condition_init(&pool->work_finished);
+
+    for(int i = 0; i < thread_count; ++i) {
+        EcsJobWorker* worker = pool->workers + i;
+        worker->pool = pool;
+        worker->index = i + 1;
+
+#if defined(_WIN32)
+        worker->thread = CreateThread(NULL, 0, ecs_job_worker_main, worker, 0, NULL);
+        bool failed = worker->thread == NULL;
+#else
+        bool failed = pthread_create(&worker->thread, NULL, ecs_job_worker_main, worker) != 0;
+#endif
+        if(failed) {
+            pool->thread_count = i;
+            ecs_job_pool_free(pool);
+            return NULL;
+        }
+    }
+
+    return pool;
+}
+
+void ecs_job_pool_free(EcsJobPool* pool) {
+    ecs_job_pool_stop(pool);
+
+    ecs_condition_free(&pool->work_finished);
+    ecs_condition_free(&pool->work_available);
+    ecs_mutex_free(&pool->mutex);
+
+    ecs_free(pool->ranges);
+    ecs_free(pool->workers);
+    ecs_free(pool);
+}
+
+int ecs_job_pool_get_thread_count(EcsJobPool* pool) {
+    return pool->thread_count;
+}
+
+void ecs_job_pool_parallel_for(EcsJobPool* pool, int count, int grain_size, EcsJobFunction function, void* data) {
+    if(count <= 0)
+        return;
+
+    int participants = pool == NULL || pool->running ? 1 : pool->thread_count + 1;
+    if(grain_size <= 0) {
+        grain_size = count / (participants * 8);
+        if(grain_size == 0)
+            grain_size = 1;
+    }
+
+    long chunks = ((long)count + grain_size - 1) / grain_size;
+
+    // Waking the workers isn't worth it if there's only enough work for a single thread.
+    if(participants == 1 || chunks == 1) {
+        for(int start = 0; start < count; start += grain_size)
+            function(data, start, count - start < grain_size ? count : start + grain_size);
+        return;
+    }
+
+    pool->running = true;
+    pool->function = function;
+    pool->data = data;
+    pool->count = count;
+    pool->grain_size = grain_size;
+    pool->context = ecs_context_get_current();
+
+    for(int i = 0; i < participants; ++i) {
+        pool->ranges[i].next = chunks * i / participants;
+        pool->ranges[i].end = chunks * (i + 1) / participants;
+    }
+
+    ecs_mutex_lock(&pool->mutex);
+    pool->generation++;
+    pool->working = pool->thread_count;
+    ecs_condition_broadcast(&pool->work_available);
+    ecs_mutex_unlock(&pool->mutex);
+
+    ecs_job_pool_participate(pool, 0);
+
+    // Every chunk has been claimed at this point, but the workers might still be running theirs.
+    ecs_mutex_lock(&pool->mutex);
+    while(pool->working > 0)
+        ecs_condition_wait(&pool->work_finished, &pool->mutex);
+    ecs_mutex_unlock(&pool->mutex);
+
+    pool->running = false;
+}
\ No newline at end of file
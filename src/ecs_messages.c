@@ -1,11 +1,5 @@
 #include "ecs_messages.h"
 
-EcsEventManager* ecs_entity_created;
-EcsEventManager* ecs_entity_disposed;
-EcsEventManager* ecs_entity_enabled;
-EcsEventManager* ecs_entity_disabled;
-EcsEvent* ecs_world_disposed;
-
 void ecs_messages_init(void) {
     // This has to be initialized first, because EcsEventManagers add a function to it.
     ecs_world_disposed = ecs_event_init();
@@ -14,4 +8,14 @@ void ecs_messages_init(void) {
     ecs_entity_disposed = ecs_event_define();
     ecs_entity_enabled = ecs_event_define();
     ecs_entity_disabled = ecs_event_define();
+}
+
+void ecs_messages_free(void) {
+    ecs_event_manager_free(ecs_entity_created);
+    ecs_event_manager_free(ecs_entity_disposed);
+    ecs_event_manager_free(ecs_entity_enabled);
+    ecs_event_manager_free(ecs_entity_disabled);
+
+    // Freed last because the managers remove themselves from it.
+    ecs_event_free(ecs_world_disposed);
 }
\ No newline at end of file
@@ -0,0 +1,27 @@
+#include "ecs_sparse_map.h"
+
+int ___ecs_sparse_null_page[ECS_SPARSE_PAGE_SIZE];
+
+void ecs_sparse_map_release_page(EcsSparseMap* map, int page) {
+    int previous = map->empty_page;
+    map->empty_page = page;
+    if(previous == -1 || previous == page)
+        return;
+
+    ecs_free(map->pages[previous]);
+    map->pages[previous] = ___ecs_sparse_null_page;
+
+    if(previous != map->page_end - 1)
+        return;
+
+    // Only freeing the highest page moves the end. The emptied page is still allocated, so the search stops there at the latest.
+    while(map->page_end > 0 && map->pages[map->page_end - 1] == ___ecs_sparse_null_page)
+        --map->page_end;
+
+    // The page count doubles as the capacity of the array. Halving it only once a quarter is used
+    // keeps a map that grows and shrinks around the same size from reallocating every time.
+    if(map->page_end <= map->page_count / 4) {
+        map->page_count /= 2;
+        map->pages = ecs_realloc(map->pages, sizeof(int*) * map->page_count);
+    }
+}
\ No newline at end of file
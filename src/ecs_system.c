@@ -58,6 +58,11 @@ void ecs_component_system_init(EcsComponentSystem* system,
     system->world = world;
     system->manager = component_type;
     system->update = update;
+    system->update_batch = NULL;
+    system->last_tick = 0;
+    system->changed_only = false;
+    system->jobs = NULL;
+    system->grain_size = 0;
 }
 
 void ecs_entity_system_init(EcsEntitySystem* system, 
@@ -72,9 +77,209 @@ void ecs_entity_system_init(EcsEntitySystem* system,
     system->world = world;
     system->entities = ecs_entity_set_build(builder, world, free_builder);
     system->update = update;
+    system->update_batch = NULL;
+    system->changed = NULL;
+    system->last_tick = 0;
+    system->jobs = NULL;
+    system->grain_size = 0;
     ecs_event_add(system->base.dispose, ecs_closure(NULL, ecs_entity_system_free));
 }
 
+void ecs_component_system_init_batch(EcsComponentSystem* system,
+                                     EcsWorld world,
+                                     EcsComponentManager* component_type,
+                                     EcsSystemUpdateComponentBatch update_batch,
+                                     EcsSystemPreupdate preupdate,
+                                     EcsSystemPostupdate postupdate)
+{
+    ecs_component_system_init(system, world, component_type, NULL, preupdate, postupdate);
+    system->update_batch = update_batch;
+}
+
+void ecs_entity_system_init_batch(EcsEntitySystem* system,
+                                  EcsWorld world,
+                                  EcsEntitySetBuilder* builder,
+                                  bool free_builder,
+                                  EcsSystemUpdateEcsEntityBatch update_batch,
+                                  EcsSystemPreupdate preupdate,
+                                  EcsSystemPostupdate postupdate)
+{
+    ecs_entity_system_init(system, world, builder, free_builder, NULL, preupdate, postupdate);
+    system->update_batch = update_batch;
+}
+
+EcsResult ecs_component_system_track_changes(EcsComponentSystem* system) {
+    if(!system->manager->track_changes)
+        return ECS_RESULT_INVALID_STATE;
+
+    system->changed_only = true;
+    return ECS_RESULT_SUCCESS;
+}
+
+EcsResult ecs_entity_system_track_changes(EcsEntitySystem* system, EcsComponentManager* component_type) {
+    if(!component_type->track_changes)
+        return ECS_RESULT_INVALID_STATE;
+
+    system->changed = component_type;
+    return ECS_RESULT_SUCCESS;
+}
+
+void ecs_component_system_set_parallel(EcsComponentSystem* system, EcsJobPool* pool, int grain_size) {
+    system->jobs = pool;
+    system->grain_size = grain_size;
+}
+
+void ecs_entity_system_set_parallel(EcsEntitySystem* system, EcsJobPool* pool, int grain_size) {
+    system->jobs = pool;
+    system->grain_size = grain_size;
+}
+
+// Visits the components in [start, end) of a chunk. versions is NULL unless only changed components are visited.
+// Batch updates are given every run of visited components that are next to each other.
+static void ecs_component_system_visit(EcsComponentSystem* system, float delta_time, char* items, unsigned int* versions, int start, int end) {
+    int size = system->manager->component_size;
+
+    if(system->update_batch == NULL) {
+        for(int i = start; i < end; i++) {
+            if(versions != NULL && versions[i] <= system->last_tick)
+                continue;
+
+            system->update(system, delta_time, items + i * size);
+        }
+        return;
+    }
+
+    if(versions == NULL) {
+        if(end > start)
+            system->update_batch(system, delta_time, items + start * size, end - start);
+        return;
+    }
+
+    while(start < end) {
+        while(start < end && versions[start] <= system->last_tick)
+            start++;
+
+        int run = start;
+        while(run < end && versions[run] > system->last_tick)
+            run++;
+
+        if(run > start)
+            system->update_batch(system, delta_time, items + start * size, run - start);
+
+        start = run;
+    }
+}
+
+// Visits the entities in [start, end) of an entity system's set.
+static void ecs_entity_system_visit(EcsEntitySystem* system, float delta_time, EcsEntity* entities, int start, int end) {
+    if(system->changed == NULL) {
+        if(system->update_batch != NULL) {
+            if(end > start)
+                system->update_batch(system, delta_time, entities + start, end - start);
+        } else {
+            for(int i = start; i < end; i++)
+                system->update(system, delta_time, entities[i]);
+        }
+        return;
+    }
+
+    while(start < end) {
+        if(!ecs_component_changed_since(entities[start], system->changed, system->last_tick)) {
+            start++;
+            continue;
+        }
+
+        if(system->update_batch == NULL) {
+            system->update(system, delta_time, entities[start++]);
+            continue;
+        }
+
+        int run = start + 1;
+        while(run < end && ecs_component_changed_since(entities[run], system->changed, system->last_tick))
+            run++;
+
+        system->update_batch(system, delta_time, entities + start, run - start);
+        start = run;
+    }
+}
+
+// A chunk of components visited by a parallel component system update.
+// offset is the index of the first component of the chunk when all of the chunks are laid end to end.
+typedef struct EcsComponentSystemChunk {
+    char* items;
+    unsigned int* versions;
+    int offset;
+} EcsComponentSystemChunk;
+
+typedef struct EcsComponentSystemJob {
+    EcsComponentSystem* system;
+    float delta_time;
+
+    // Has one extra element at the end whose offset is the total number of components.
+    EcsComponentSystemChunk* chunks;
+    int chunk_count;
+} EcsComponentSystemJob;
+
+static void ecs_component_system_job(void* data, int start, int end) {
+    EcsComponentSystemJob* job = data;
+
+    // Find the last chunk that starts at or before the first component of the range.
+    int chunk = 0;
+    int high = job->chunk_count - 1;
+    while(chunk < high) {
+        int mid = (chunk + high + 1) / 2;
+        if(job->chunks[mid].offset <= start)
+            chunk = mid;
+        else
+            high = mid - 1;
+    }
+
+    // Split the range at the chunk boundaries, since the components of different chunks aren't contiguous.
+    while(start < end) {
+        EcsComponentSystemChunk* current = job->chunks + chunk++;
+        int chunk_end = current[1].offset < end ? current[1].offset : end;
+        if(chunk_end > start)
+            ecs_component_system_visit(job->system, job->delta_time, current->items, current->versions, start - current->offset, chunk_end - current->offset);
+
+        start = chunk_end;
+    }
+}
+
+static void ecs_component_system_update_parallel(EcsComponentSystem* system, float delta_time) {
+    EcsComponentSystemJob job = { system, delta_time, NULL, 0 };
+    int capacity = 0;
+    int total = 0;
+    int component_count;
+    char* items;
+
+    for(int chunk = 0; (items = ecs_component_get_chunk(system->world, system->manager, chunk, &component_count)) != NULL; chunk++) {
+        ECS_ARRAY_RESIZE(job.chunks, capacity, job.chunk_count + 1, sizeof(EcsComponentSystemChunk));
+        EcsComponentSystemChunk* current = job.chunks + job.chunk_count++;
+        current->items = items;
+        current->versions = system->changed_only ? ecs_component_get_versions(system->world, system->manager, chunk, &component_count) : NULL;
+        current->offset = total;
+        total += component_count;
+    }
+
+    if(job.chunk_count != 0) {
+        job.chunks[job.chunk_count].offset = total;
+        ecs_job_pool_parallel_for(system->jobs, total, system->grain_size, ecs_component_system_job, &job);
+    }
+
+    ecs_free(job.chunks);
+}
+
+typedef struct EcsEntitySystemJob {
+    EcsEntitySystem* system;
+    float delta_time;
+    EcsEntity* entities;
+} EcsEntitySystemJob;
+
+static void ecs_entity_system_job(void* data, int start, int end) {
+    EcsEntitySystemJob* job = data;
+    ecs_entity_system_visit(job->system, job->delta_time, job->entities, start, end);
+}
+
 void ecs_action_system_init(EcsActionSystem* system, 
                             EcsSystemUpdateAction update, 
                             EcsSystemPreupdate preupdate, 
@@ -137,6 +342,197 @@ void ecs_sequential_system_init_list(EcsSequentialSystem* system,
     ecs_event_add(system->base.dispose, ecs_closure(NULL, ecs_sequential_system_free));
 }
 
+static void ecs_scheduler_system_free(void* data, EcsSystem* system) {
+    EcsSchedulerSystem* scheduler = (EcsSchedulerSystem*)system;
+    for(int i = 0; i < scheduler->count; ++i) {
+        EcsScheduledSystem* scheduled = scheduler->systems + i;
+        if(scheduler->free_children) {
+            ecs_system_free_resources(scheduled->system);
+            ecs_free(scheduled->system);
+        }
+        ecs_free(scheduled->reads);
+        ecs_free(scheduled->writes);
+    }
+    ecs_free(scheduler->systems);
+    ecs_free(scheduler->order);
+    ecs_free(scheduler->levels);
+}
+
+void ecs_scheduler_system_init(EcsSchedulerSystem* system,
+                               EcsJobPool* pool,
+                               EcsSystemPreupdate preupdate,
+                               EcsSystemPostupdate postupdate,
+                               bool free_children)
+{
+    ecs_system_init(&system->base, ECS_SYSTEM_TYPE_SCHEDULER, preupdate, postupdate);
+    system->jobs = pool;
+    system->systems = NULL;
+    system->count = 0;
+    system->capacity = 0;
+    system->order = NULL;
+    system->levels = NULL;
+    system->level_count = 0;
+    system->dirty = false;
+    system->free_children = free_children;
+    ecs_event_add(system->base.dispose, ecs_closure(NULL, ecs_scheduler_system_free));
+}
+
+static EcsComponentManager** ecs_scheduler_copy_components(EcsComponentManager** components, int count) {
+    if(count <= 0)
+        return NULL;
+
+    EcsComponentManager** copy = ecs_malloc(sizeof(EcsComponentManager*) * count);
+    ecs_memcpy(copy, components, sizeof(EcsComponentManager*) * count);
+    return copy;
+}
+
+// Systems that only visit changed components advance the tick of their world after every update,
+// which isn't thread safe, so they can't run at the same time as any other system.
+static bool ecs_scheduler_advances_tick(EcsSystem* system) {
+    switch(system->type) {
+        case ECS_SYSTEM_TYPE_COMPONENT:
+            return ((EcsComponentSystem*)system)->changed_only;
+        case ECS_SYSTEM_TYPE_ENTITY:
+            return ((EcsEntitySystem*)system)->changed != NULL;
+        default:
+            return false;
+    }
+}
+
+// Gets the entity set of a system. Getting the entities updates the set, so systems that share a set conflict.
+static EcsEntitySet* ecs_scheduler_entity_set(EcsSystem* system) {
+    return system->type == ECS_SYSTEM_TYPE_ENTITY ? ((EcsEntitySystem*)system)->entities : NULL;
+}
+
+static void ecs_scheduler_system_push(EcsSchedulerSystem* scheduler,
+                                      EcsSystem* system,
+                                      EcsComponentManager** reads,
+                                      int read_count,
+                                      EcsComponentManager** writes,
+                                      int write_count,
+                                      bool exclusive)
+{
+    ECS_ARRAY_RESIZE(scheduler->systems, scheduler->capacity, scheduler->count, sizeof(EcsScheduledSystem));
+
+    EcsScheduledSystem* scheduled = scheduler->systems + scheduler->count++;
+    scheduled->system = system;
+    scheduled->reads = ecs_scheduler_copy_components(reads, read_count);
+    scheduled->read_count = read_count > 0 ? read_count : 0;
+    scheduled->writes = ecs_scheduler_copy_components(writes, write_count);
+    scheduled->write_count = write_count > 0 ? write_count : 0;
+    scheduled->exclusive = exclusive || ecs_scheduler_advances_tick(system);
+    scheduled->level = 0;
+    scheduler->dirty = true;
+}
+
+void ecs_scheduler_system_add(EcsSchedulerSystem* scheduler,
+                              EcsSystem* system,
+                              EcsComponentManager** reads,
+                              int read_count,
+                              EcsComponentManager** writes,
+                              int write_count)
+{
+    ecs_scheduler_system_push(scheduler, system, reads, read_count, writes, write_count, false);
+}
+
+void ecs_scheduler_system_add_exclusive(EcsSchedulerSystem* scheduler, EcsSystem* system) {
+    ecs_scheduler_system_push(scheduler, system, NULL, 0, NULL, 0, true);
+}
+
+static bool ecs_scheduler_contains(EcsComponentManager** components, int count, EcsComponentManager* manager) {
+    for(int i = 0; i < count; ++i) {
+        if(components[i] == manager)
+            return true;
+    }
+
+    return false;
+}
+
+static bool ecs_scheduler_conflicts(EcsScheduledSystem* left, EcsScheduledSystem* right) {
+    if(left->exclusive || right->exclusive)
+        return true;
+
+    EcsEntitySet* set = ecs_scheduler_entity_set(left->system);
+    if(set != NULL && set == ecs_scheduler_entity_set(right->system))
+        return true;
+
+    for(int i = 0; i < left->write_count; ++i) {
+        if(ecs_scheduler_contains(right->reads, right->read_count, left->writes[i]) ||
+           ecs_scheduler_contains(right->writes, right->write_count, left->writes[i]))
+        {
+            return true;
+        }
+    }
+
+    for(int i = 0; i < right->write_count; ++i) {
+        if(ecs_scheduler_contains(left->reads, left->read_count, right->writes[i]))
+            return true;
+    }
+
+    return false;
+}
+
+// Groups the systems into levels. Every system runs after all of the earlier systems it conflicts with,
+// so the systems of a level never conflict with each other and can run at the same time.
+static void ecs_scheduler_system_build(EcsSchedulerSystem* scheduler) {
+    scheduler->level_count = 0;
+    for(int i = 0; i < scheduler->count; ++i) {
+        EcsScheduledSystem* scheduled = scheduler->systems + i;
+        scheduled->level = 0;
+        for(int j = 0; j < i; ++j) {
+            EcsScheduledSystem* earlier = scheduler->systems + j;
+            if(earlier->level >= scheduled->level && ecs_scheduler_conflicts(earlier, scheduled))
+                scheduled->level = earlier->level + 1;
+        }
+
+        if(scheduled->level >= scheduler->level_count)
+            scheduler->level_count = scheduled->level + 1;
+    }
+
+    scheduler->order = ecs_realloc(scheduler->order, sizeof(int) * (scheduler->count == 0 ? 1 : scheduler->count));
+    scheduler->levels = ecs_realloc(scheduler->levels, sizeof(int) * (scheduler->level_count + 1));
+
+    // Counting sort by level, which keeps the systems of each level in the order they were added.
+    ecs_memset(scheduler->levels, 0, sizeof(int) * (scheduler->level_count + 1));
+    for(int i = 0; i < scheduler->count; ++i)
+        scheduler->levels[scheduler->systems[i].level + 1]++;
+
+    for(int level = 0; level < scheduler->level_count; ++level)
+        scheduler->levels[level + 1] += scheduler->levels[level];
+
+    for(int i = 0; i < scheduler->count; ++i)
+        scheduler->order[scheduler->levels[scheduler->systems[i].level]++] = i;
+
+    // Filling in the order moved every start to the start of the next level, so shift them back.
+    for(int level = scheduler->level_count; level > 0; --level)
+        scheduler->levels[level] = scheduler->levels[level - 1];
+    scheduler->levels[0] = 0;
+
+    scheduler->dirty = false;
+}
+
+typedef struct EcsSchedulerJob {
+    EcsSchedulerSystem* scheduler;
+    float delta_time;
+    int start;
+} EcsSchedulerJob;
+
+static void ecs_scheduler_system_job(void* data, int start, int end) {
+    EcsSchedulerJob* job = data;
+    for(int i = start; i < end; ++i)
+        ecs_system_update(job->scheduler->systems[job->scheduler->order[job->start + i]].system, job->delta_time);
+}
+
+static void ecs_scheduler_system_update(EcsSchedulerSystem* scheduler, float delta_time) {
+    if(scheduler->dirty)
+        ecs_scheduler_system_build(scheduler);
+
+    for(int level = 0; level < scheduler->level_count; ++level) {
+        EcsSchedulerJob job = { scheduler, delta_time, scheduler->levels[level] };
+        ecs_job_pool_parallel_for(scheduler->jobs, scheduler->levels[level + 1] - job.start, 1, ecs_scheduler_system_job, &job);
+    }
+}
+
 void ecs_system_update(EcsSystem* system, float delta_time) {
     if(!system->enabled)
         return;
@@ -162,18 +558,37 @@ void ecs_system_update(EcsSystem* system, float delta_time) {
             }
             break;
         }
+        case ECS_SYSTEM_TYPE_SCHEDULER:
+            ecs_scheduler_system_update((EcsSchedulerSystem*)system, delta_time);
+            break;
+
         case ECS_SYSTEM_TYPE_COMPONENT:
         {
             EcsComponentSystem* component_system = (EcsComponentSystem*)system;
-            if(component_system->update == NULL)
+            if(component_system->update == NULL && component_system->update_batch == NULL)
                 break;
 
             // The items array has to be of type char* because you can't increment a void ptr.
-            int component_count;
-            char* items = ecs_component_get_all(component_system->world, component_system->manager, &component_count);
+            if(component_system->jobs != NULL) {
+                ecs_component_system_update_parallel(component_system, delta_time);
+            } else {
+                int component_count;
+                char* items;
 
-            for(int i = 0; i < component_count; i++)
-                component_system->update(component_system, delta_time, &items[i * component_system->manager->component_size]);
+                for(int chunk = 0; (items = ecs_component_get_chunk(component_system->world, component_system->manager, chunk, &component_count)) != NULL; chunk++) {
+                    unsigned int* versions = NULL;
+                    if(component_system->changed_only)
+                        versions = ecs_component_get_versions(component_system->world, component_system->manager, chunk, &component_count);
+
+                    ecs_component_system_visit(component_system, delta_time, items, versions, 0, component_count);
+                }
+            }
+
+            // Components changed by this update keep the current tick, so they aren't visited again by the next one.
+            if(component_system->changed_only) {
+                component_system->last_tick = ecs_world_get_tick(component_system->world);
+                ecs_world_advance_tick(component_system->world);
+            }
 
             break;
         }
@@ -184,18 +599,28 @@ void ecs_system_update(EcsSystem* system, float delta_time) {
             // ComponentEnum field and for each entity it would compare against the fields.
             // That version is actually FASTER if the components are being changed frequently
             // (i.e. like every frame). Using an EcsEntitySet is faster when the components aren't changing,
-            // which is the more general case, so it's used instead. If this is too large of a bottleneck,
-            // a hybrid solution may be applicable.
+            // which is the more general case, so it's used instead. Sets that change too much every frame
+            // switch to scanning the world on their own (see EcsEntitySetMode).
 
             EcsEntitySystem* entity_system = (EcsEntitySystem*)system;
-            if(entity_system->update == NULL)
+            if(entity_system->update == NULL && entity_system->update_batch == NULL)
                 break;
 
             int entity_count;
             EcsEntity* entities = ecs_entity_set_get_entities(entity_system->entities, &entity_count);
 
-            for(int i = 0; i < entity_count; i++)
-                entity_system->update(entity_system, delta_time, entities[i]);
+            if(entity_system->jobs != NULL) {
+                EcsEntitySystemJob job = { entity_system, delta_time, entities };
+                ecs_job_pool_parallel_for(entity_system->jobs, entity_count, entity_system->grain_size, ecs_entity_system_job, &job);
+            } else {
+                ecs_entity_system_visit(entity_system, delta_time, entities, 0, entity_count);
+            }
+
+            if(entity_system->changed == NULL)
+                break;
+
+            entity_system->last_tick = ecs_world_get_tick(entity_system->world);
+            ecs_world_advance_tick(entity_system->world);
 
             break;
         }
@@ -9,6 +9,15 @@ struct EcsWorldImpl {
     EcsIntDispenser dispenser;
     ComponentEnum* entity_components;
     int capacity;
+
+    // The generation of each entity slot. Incremented every time the entity in the slot is freed,
+    // so that handles to the old entity stop matching. Kept when the world is freed, so that handles
+    // to its entities don't match the entities of a new world that reuses the id.
+    unsigned int* generations;
+    int generation_capacity;
+
+    // Starts at 1 so that a version of 0 always means the component hasn't changed.
+    unsigned int tick;
 };
 
 struct EcsWorldManager {
@@ -17,31 +26,44 @@ struct EcsWorldManager {
     int capacity;
 };
 
-static struct EcsWorldManager world_manager;
-
-ComponentFlag ecs_is_alive_flag;
-ComponentFlag ecs_is_enabled_flag;
+// The world manager of the current context.
+#define world_manager (*ecs_context_get_current()->worlds)
 
 void ecs_world_system_init(void) {
     ecs_is_alive_flag = ecs_component_flag_get();
     ecs_is_enabled_flag = ecs_component_flag_get();
 
+    ecs_context_get_current()->worlds = ecs_malloc(sizeof(struct EcsWorldManager));
     ecs_dispenser_init_start(&world_manager.dispenser, 1);
     world_manager.worlds = NULL;
     world_manager.capacity = 0;
 }
 
+void ecs_world_system_free(void) {
+    EcsContext* context = ecs_context_get_current();
+    for(int i = 0; i < context->worlds->capacity; ++i)
+        ecs_free(context->worlds->worlds[i].generations);
+
+    ecs_dispenser_free_resources(&context->worlds->dispenser);
+    ecs_free(context->worlds->worlds);
+    ecs_free(context->worlds);
+    context->worlds = NULL;
+}
+
 EcsWorld ecs_world_init(void) {
     EcsWorld id = ecs_dispenser_get(&world_manager.dispenser);
 
-    ECS_ARRAY_RESIZE(world_manager.worlds, world_manager.capacity, id, sizeof(struct EcsWorldImpl));
+    // Slots that were never used start without generations. Reused slots keep the generations of the freed world.
+    struct EcsWorldImpl empty = { 0 };
+    ECS_ARRAY_RESIZE_DEFAULT(world_manager.worlds, world_manager.capacity, id, sizeof(struct EcsWorldImpl), empty);
 
     struct EcsWorldImpl* world = world_manager.worlds + id;
 
     ecs_dispenser_init(&world->dispenser);
     world->entity_components = NULL;
     world->capacity = 0;
-    
+    world->tick = 1;
+
     return id;
 }
 
@@ -63,15 +85,29 @@ EcsResult ecs_world_free(EcsWorld world) {
         ecs_free(impl->entity_components);
     }
 
+    // The generations outlive the world. Every slot moves on to a new generation so that handles
+    // to the entities that were still alive stop matching, even after the world id is reused.
+    for(int i = 0; i < impl->generation_capacity; ++i)
+        impl->generations[i]++;
+
     ecs_dispenser_release(&world_manager.dispenser, world);
 
     return ECS_RESULT_SUCCESS;
 }
 
+unsigned int ecs_world_get_tick(EcsWorld world) {
+    return world_manager.worlds[world].tick;
+}
+
+unsigned int ecs_world_advance_tick(EcsWorld world) {
+    return ++world_manager.worlds[world].tick;
+}
+
 EcsEntity ecs_create_entity(EcsWorld world) {
     struct EcsWorldImpl* impl = world_manager.worlds + world;
     int id = ecs_dispenser_get(&impl->dispenser);
     ECS_ARRAY_RESIZE_DEFAULT(impl->entity_components, impl->capacity, id, sizeof(ComponentEnum), COMPONENT_ENUM_DEFAULT);
+    ECS_ARRAY_RESIZE_DEFAULT(impl->generations, impl->generation_capacity, id, sizeof(unsigned int), 0);
     ComponentEnum* entity_components = impl->entity_components + id;
 
     ecs_component_enum_set_flag(entity_components, ecs_is_alive_flag, true);
@@ -98,6 +134,7 @@ EcsResult ecs_entity_free(EcsEntity entity) {
     ecs_event_publish(entity.world, ecs_entity_disposed, void (*)(void*, EcsEntityDisposedMessage*), &message);
     
     ecs_component_enum_clear(impl->entity_components + entity.id);
+    impl->generations[entity.id]++;
     ecs_dispenser_release(&impl->dispenser, entity.id);
 
     return ECS_RESULT_SUCCESS;
@@ -163,6 +200,39 @@ bool ecs_entity_is_enabled(EcsEntity entity) {
     return ecs_component_enum_get_flag(impl->entity_components + entity.id, ecs_is_enabled_flag);
 }
 
+unsigned int ecs_entity_get_generation(EcsEntity entity) {
+    return world_manager.worlds[entity.world].generations[entity.id] & ECS_HANDLE_GENERATION_MASK;
+}
+
+EcsHandle ecs_entity_get_handle(EcsEntity entity) {
+    // The world id would be truncated and the handle would refer to an entity of a different world.
+    if(!ecs_entity_is_alive(entity) || (unsigned int)entity.world >= (1u << ECS_HANDLE_WORLD_BITS))
+        return ECS_HANDLE_NULL;
+
+    return ecs_handle_pack(entity.world, entity.id, ecs_entity_get_generation(entity));
+}
+
+bool ecs_handle_is_alive(EcsHandle handle) {
+    EcsWorld world = ecs_handle_get_world(handle);
+    if(world <= 0 || world >= world_manager.capacity)
+        return false;
+
+    // The entity in the slot has been freed at least once since the handle was made if the generations don't match,
+    // and a freed slot always has a newer generation, so there's no need to check the alive flag.
+    struct EcsWorldImpl* impl = world_manager.worlds + world;
+    unsigned int id = (unsigned int)ecs_handle_get_id(handle);
+    return id < (unsigned int)impl->generation_capacity
+        && (impl->generations[id] & ECS_HANDLE_GENERATION_MASK) == ecs_handle_get_generation(handle);
+}
+
+bool ecs_handle_get_alive_entity(EcsHandle handle, EcsEntity* entity) {
+    if(!ecs_handle_is_alive(handle))
+        return false;
+
+    *entity = ecs_handle_get_entity(handle);
+    return true;
+}
+
 ComponentEnum* ecs_entity_get_components(EcsEntity entity) {
     struct EcsWorldImpl* impl = world_manager.worlds + entity.world;
     return impl->entity_components + entity.id;
@@ -0,0 +1,187 @@
+#include <stdlib.h>
+
+#include "check.h"
+#include "ecs.h"
+
+typedef struct Position {
+    float x;
+    float y;
+} Position;
+
+typedef struct Velocity {
+    float x;
+    float y;
+} Velocity;
+
+static EcsComponentManager* position_component;
+static EcsComponentManager* velocity_component;
+static EcsComponentManager* frozen_component;
+static EcsWorld world;
+static int positions_freed;
+
+static void position_destructor(void* item) {
+    positions_freed++;
+}
+
+void archetype_setup(void) {
+    ecs_init();
+    position_component = ecs_component_define_archetype(sizeof(Position), NULL, position_destructor);
+    velocity_component = ecs_component_define_archetype(sizeof(Velocity), NULL, NULL);
+    frozen_component = ecs_component_define_archetype(sizeof(bool), NULL, NULL);
+}
+
+void archetype_teardown(void) {
+    ecs_component_free(position_component);
+    ecs_component_free(velocity_component);
+    ecs_component_free(frozen_component);
+}
+
+void archetype_start(void) {
+    world = ecs_world_init();
+    positions_freed = 0;
+}
+
+void archetype_stop(void) {
+    ecs_world_free(world);
+}
+
+START_TEST(archetype_component_keeps_value_when_entity_moves) {
+    EcsEntity entity = ecs_create_entity(world);
+    Position* position = ecs_component_set(entity, position_component);
+    position->x = 3;
+    position->y = 4;
+
+    ecs_component_set(entity, velocity_component);
+    ck_assert(ecs_component_exists(entity, position_component));
+    ck_assert(ecs_component_exists(entity, velocity_component));
+
+    ck_assert(ecs_component_get(entity, position_component, &position) == ECS_RESULT_SUCCESS);
+    ck_assert_msg(position->x == 3 && position->y == 4, "Component value lost when the entity changed tables");
+
+    ecs_component_remove(entity, velocity_component);
+    ck_assert(!ecs_component_exists(entity, velocity_component));
+    ck_assert(ecs_component_get(entity, position_component, &position) == ECS_RESULT_SUCCESS);
+    ck_assert(position->x == 3 && position->y == 4);
+
+    ecs_entity_free(entity);
+    ck_assert_msg(positions_freed == 1, "Destructor not called when the entity was freed");
+}
+END_TEST
+
+START_TEST(archetype_remove_keeps_other_rows) {
+    EcsEntity entities[3];
+    for(int i = 0; i < 3; i++) {
+        entities[i] = ecs_create_entity(world);
+        ((Position*)ecs_component_set(entities[i], position_component))->x = i;
+    }
+
+    ecs_component_remove(entities[0], position_component);
+
+    Position* position;
+    ck_assert(ecs_component_get(entities[0], position_component, &position) == ECS_RESULT_INVALID_ENTITY);
+    for(int i = 1; i < 3; i++) {
+        ck_assert(ecs_component_get(entities[i], position_component, &position) == ECS_RESULT_SUCCESS);
+        ck_assert(position->x == i);
+    }
+
+    for(int i = 0; i < 3; i++)
+        ecs_entity_free(entities[i]);
+}
+END_TEST
+
+START_TEST(archetype_query_visits_matching_tables) {
+    EcsEntity moving[4];
+    EcsEntity frozen[2];
+    EcsEntity still = ecs_create_entity(world);
+    ecs_component_set(still, position_component);
+
+    for(int i = 0; i < 4; i++) {
+        moving[i] = ecs_create_entity(world);
+        ((Position*)ecs_component_set(moving[i], position_component))->x = 0;
+        ((Velocity*)ecs_component_set(moving[i], velocity_component))->x = 1;
+    }
+
+    for(int i = 0; i < 2; i++) {
+        frozen[i] = ecs_create_entity(world);
+        ecs_component_set(frozen[i], frozen_component);
+        ((Velocity*)ecs_component_set(frozen[i], velocity_component))->x = 1;
+        ((Position*)ecs_component_set(frozen[i], position_component))->x = 0;
+    }
+
+    EcsComponentManager* with[] = { position_component, velocity_component };
+    EcsComponentManager* without[] = { frozen_component };
+    EcsArchetypeQuery* query = ecs_archetype_query_init(world, with, 2, without, 1);
+    ck_assert(query != NULL);
+
+    int visited = 0;
+    EcsArchetypeIterator it;
+    ecs_archetype_query_iter(query, &it);
+    while(ecs_archetype_iter_next(&it)) {
+        Position* positions = it.columns[0];
+        Velocity* velocities = it.columns[1];
+        for(int i = 0; i < it.count; i++) {
+            positions[i].x += velocities[i].x;
+            visited++;
+        }
+    }
+
+    ck_assert_msg(visited == 4, "Query visited the wrong number of entities");
+
+    Position* position;
+    ecs_component_get(moving[2], position_component, &position);
+    ck_assert(position->x == 1);
+    ecs_component_get(frozen[0], position_component, &position);
+    ck_assert(position->x == 0);
+
+    // Tables created after the query are picked up by the next iteration.
+    EcsEntity late = ecs_create_entity(world);
+    ecs_component_set(late, velocity_component);
+    ecs_component_set(late, position_component);
+
+    visited = 0;
+    ecs_archetype_query_iter(query, &it);
+    while(ecs_archetype_iter_next(&it))
+        visited += it.count;
+
+    ck_assert(visited == 5);
+
+    ecs_archetype_query_free(query);
+}
+END_TEST
+
+START_TEST(archetype_query_rejects_pool_components) {
+    EcsComponentManager* pool_component = ecs_component_define(sizeof(int), NULL, NULL);
+    EcsComponentManager* with[] = { position_component, pool_component };
+    ck_assert(ecs_archetype_query_init(world, with, 2, NULL, 0) == NULL);
+
+    // Pool components aren't part of the table signatures, so they can't be excluded either.
+    EcsComponentManager* without[] = { pool_component };
+    ck_assert_msg(ecs_archetype_query_init(world, with, 1, without, 1) == NULL, "Query ignored a pool without component");
+    ecs_component_free(pool_component);
+}
+END_TEST
+
+int main(void) {
+    int number_failed;
+
+    Suite* s = suite_create("ECS Archetypes");
+    TCase* tc_archetype = tcase_create("ECS Archetypes");
+
+    tcase_add_unchecked_fixture(tc_archetype, archetype_setup, archetype_teardown);
+    tcase_add_checked_fixture(tc_archetype, archetype_start, archetype_stop);
+
+    tcase_add_test(tc_archetype, archetype_component_keeps_value_when_entity_moves);
+    tcase_add_test(tc_archetype, archetype_remove_keeps_other_rows);
+    tcase_add_test(tc_archetype, archetype_query_visits_matching_tables);
+    tcase_add_test(tc_archetype, archetype_query_rejects_pool_components);
+
+    suite_add_tcase(s, tc_archetype);
+
+    SRunner* sr = srunner_create(s);
+
+    srunner_run_all(sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+
+    return number_failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
\ No newline at end of file
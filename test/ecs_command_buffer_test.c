@@ -0,0 +1,191 @@
+#include <stdlib.h>
+
+#include "check.h"
+#include "ecs.h"
+
+static EcsComponentManager* int_component;
+static EcsComponentManager* bool_component;
+static EcsComponentManager* owned_component;
+static EcsWorld world;
+
+static int destroyed;
+
+static void owned_constructor(void* component) {
+    *(int**)component = NULL;
+}
+
+// Owns a heap allocation so that a missing destructor call is reported as a leak as well.
+// Only values recorded by the buffer are counted, not the constructed components they replace.
+static void owned_destructor(void* component) {
+    int** value = component;
+    if(*value != NULL)
+        destroyed++;
+
+    free(*value);
+    *value = NULL;
+}
+
+void command_buffer_setup(void) {
+    ecs_init();
+    int_component = ecs_component_define(sizeof(int), NULL, NULL);
+    bool_component = ecs_component_define(sizeof(bool), NULL, NULL);
+    owned_component = ecs_component_define(sizeof(int*), owned_constructor, owned_destructor);
+}
+
+void command_buffer_teardown(void) {
+    ecs_component_free(int_component);
+    ecs_component_free(bool_component);
+    ecs_component_free(owned_component);
+}
+
+void command_buffer_start(void) {
+    world = ecs_world_init();
+}
+
+void command_buffer_stop(void) {
+    ecs_world_free(world);
+}
+
+START_TEST(command_buffer_defers_changes) {
+    EcsEntity entity = ecs_create_entity(world);
+    EcsCommandBuffer* buffer = ecs_command_buffer_init(world);
+
+    int value = 7;
+    ecs_command_buffer_set(buffer, entity, int_component, &value);
+    ecs_command_buffer_disable(buffer, entity);
+    ck_assert_msg(!ecs_component_exists(entity, int_component), "Command was applied before playback");
+    ck_assert(ecs_command_buffer_count(buffer) == 2);
+
+    ecs_command_buffer_playback(buffer);
+    ck_assert(ecs_command_buffer_count(buffer) == 0);
+
+    int* component;
+    ck_assert(ecs_component_get(entity, int_component, &component) == ECS_RESULT_SUCCESS);
+    ck_assert(*component == 7);
+    ck_assert(!ecs_entity_is_enabled(entity));
+
+    ecs_command_buffer_free(buffer);
+}
+END_TEST
+
+START_TEST(command_buffer_creates_placeholder_entities) {
+    EcsCommandBuffer* buffer = ecs_command_buffer_init(world);
+
+    EcsEntity placeholders[3];
+    for(int i = 0; i < 3; i++) {
+        placeholders[i] = ecs_command_buffer_create_entity(buffer);
+        ecs_command_buffer_set(buffer, placeholders[i], int_component, &i);
+    }
+
+    ecs_command_buffer_playback(buffer);
+
+    for(int i = 0; i < 3; i++) {
+        EcsEntity entity = ecs_command_buffer_resolve(buffer, placeholders[i]);
+        ck_assert(ecs_entity_is_alive(entity));
+
+        int* component;
+        ck_assert(ecs_component_get(entity, int_component, &component) == ECS_RESULT_SUCCESS);
+        ck_assert(*component == i);
+    }
+
+    ecs_command_buffer_free(buffer);
+}
+END_TEST
+
+START_TEST(command_buffer_coalesces_commands) {
+    EcsEntity kept = ecs_create_entity(world);
+    EcsEntity freed = ecs_create_entity(world);
+    EcsCommandBuffer* buffer = ecs_command_buffer_init(world);
+
+    int first = 1;
+    int second = 2;
+    ecs_command_buffer_set(buffer, kept, bool_component, NULL);
+    ecs_command_buffer_set(buffer, freed, int_component, &first);
+    ecs_command_buffer_set(buffer, kept, int_component, &first);
+    ecs_command_buffer_remove(buffer, kept, bool_component);
+    ecs_command_buffer_set(buffer, kept, int_component, &second);
+    ecs_command_buffer_free_entity(buffer, freed);
+
+    EcsEntitySetBuilder* builder = ecs_entity_set_builder_init();
+    ecs_entity_set_with(builder, int_component);
+    EcsEntitySet* set = ecs_entity_set_build(builder, world, true);
+
+    ecs_command_buffer_playback(buffer);
+
+    int* component;
+    ck_assert(!ecs_component_exists(kept, bool_component));
+    ck_assert(ecs_component_get(kept, int_component, &component) == ECS_RESULT_SUCCESS);
+    ck_assert_msg(*component == 2, "The last set of a component wasn't applied");
+    ck_assert(!ecs_entity_is_alive(freed));
+
+    int count;
+    EcsEntity* entities = ecs_entity_set_get_entities(set, &count);
+    ck_assert(count == 1 && entities[0].id == kept.id);
+
+    ecs_entity_set_free(set);
+    ecs_command_buffer_free(buffer);
+}
+END_TEST
+
+static int* owned_value(int value) {
+    int* result = malloc(sizeof(int));
+    *result = value;
+    return result;
+}
+
+START_TEST(command_buffer_destroys_discarded_values) {
+    EcsEntity kept = ecs_create_entity(world);
+    EcsEntity freed = ecs_create_entity(world);
+    EcsCommandBuffer* buffer = ecs_command_buffer_init(world);
+    destroyed = 0;
+
+    int* value = owned_value(1);
+    ecs_command_buffer_set(buffer, kept, owned_component, &value);
+    value = owned_value(2);
+    ecs_command_buffer_set(buffer, kept, owned_component, &value);
+    value = owned_value(3);
+    ecs_command_buffer_set(buffer, freed, owned_component, &value);
+    ecs_command_buffer_free_entity(buffer, freed);
+
+    ecs_command_buffer_playback(buffer);
+    ck_assert_msg(destroyed == 2, "Overridden values weren't destroyed");
+
+    int** component;
+    ck_assert(ecs_component_get(kept, owned_component, &component) == ECS_RESULT_SUCCESS);
+    ck_assert(**component == 2);
+
+    // Values that are still waiting to be played back are destroyed with the buffer.
+    value = owned_value(4);
+    ecs_command_buffer_set(buffer, kept, owned_component, &value);
+    ecs_command_buffer_free(buffer);
+    ck_assert_msg(destroyed == 3, "Pending value wasn't destroyed");
+
+    ecs_component_remove(kept, owned_component);
+    ck_assert(destroyed == 4);
+}
+END_TEST
+
+int main(void) {
+    int number_failed;
+
+    Suite* s = suite_create("ECS Command Buffers");
+    TCase* tc_command_buffer = tcase_create("ECS Command Buffers");
+
+    tcase_add_unchecked_fixture(tc_command_buffer, command_buffer_setup, command_buffer_teardown);
+    tcase_add_checked_fixture(tc_command_buffer, command_buffer_start, command_buffer_stop);
+
+    tcase_add_test(tc_command_buffer, command_buffer_defers_changes);
+    tcase_add_test(tc_command_buffer, command_buffer_creates_placeholder_entities);
+    tcase_add_test(tc_command_buffer, command_buffer_coalesces_commands);
+    tcase_add_test(tc_command_buffer, command_buffer_destroys_discarded_values);
+
+    suite_add_tcase(s, tc_command_buffer);
+
+    SRunner* sr = srunner_create(s);
+
+    srunner_run_all(sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+
+    return number_failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
\ No newline at end of file
@@ -0,0 +1,212 @@
+#include <stdlib.h>
+
+#include <check.h>
+#include "ecs.h"
+
+static EcsComponentManager* int_component;
+static EcsComponentManager* float_component;
+
+static EcsWorld world;
+
+void group_setup(void) {
+    ecs_init();
+    int_component = ecs_component_define(sizeof(int), NULL, NULL);
+    float_component = ecs_component_define(sizeof(float), NULL, NULL);
+}
+
+void group_teardown(void) {
+    ecs_component_free(int_component);
+    ecs_component_free(float_component);
+}
+
+void group_start(void) {
+    world = ecs_world_init();
+}
+
+void group_stop(void) {
+    ecs_world_free(world);
+}
+
+// Checks that the components of the group line up with each other and with the entities that own both types.
+static void check_group(EcsComponentGroup* group, EcsEntity* entities, int entity_count) {
+    int count;
+    int* ints = ecs_component_group_get_components(group, int_component, &count);
+    float* floats = ecs_component_group_get_components(group, float_component, &count);
+
+    for(int i = 0; i < count; i++) {
+        EcsEntity entity = ecs_component_group_get_entity(group, i);
+        ck_assert_msg(ecs_component_try_get(entity, int_component) == ints + i, "Int component is out of place");
+        ck_assert_msg(ecs_component_try_get(entity, float_component) == floats + i, "Float component is out of place");
+        ck_assert((float)ints[i] == floats[i]);
+    }
+
+    int owners = 0;
+    for(int i = 0; i < entity_count; i++) {
+        if(ecs_component_has(entities[i], int_component) && ecs_component_has(entities[i], float_component))
+            owners++;
+    }
+
+    ck_assert_msg(owners == count, "Group size doesn't match the number of entities that own both components");
+}
+
+START_TEST(group_packs_existing_entities) {
+    EcsEntity entities[10];
+    for(int i = 0; i < 10; i++) {
+        entities[i] = ecs_create_entity(world);
+        *(int*)ecs_component_set(entities[i], int_component) = i;
+        if(i % 2 == 0)
+            *(float*)ecs_component_set(entities[i], float_component) = (float)i;
+    }
+
+    EcsComponentManager* managers[] = { int_component, float_component };
+    EcsComponentGroup* group = ecs_component_group_init(world, managers, 2);
+    ck_assert(group != NULL);
+    ck_assert_msg(ecs_component_group_size(group) == 5, "Group didn't include the existing entities");
+    check_group(group, entities, 10);
+
+    ecs_component_group_free(group);
+}
+END_TEST
+
+START_TEST(group_follows_component_changes) {
+    EcsComponentManager* managers[] = { int_component, float_component };
+    EcsComponentGroup* group = ecs_component_group_init(world, managers, 2);
+
+    EcsEntity entities[12];
+    for(int i = 0; i < 12; i++) {
+        entities[i] = ecs_create_entity(world);
+        *(int*)ecs_component_set(entities[i], int_component) = i;
+        if(i % 3 != 0)
+            *(float*)ecs_component_set(entities[i], float_component) = (float)i;
+    }
+
+    ck_assert(ecs_component_group_size(group) == 8);
+    check_group(group, entities, 12);
+
+    ecs_component_remove(entities[1], int_component);
+    ecs_component_remove(entities[5], float_component);
+    *(float*)ecs_component_set(entities[3], float_component) = 3.0f;
+    ecs_entity_free(entities[7]);
+    check_group(group, entities, 12);
+    ck_assert(ecs_component_group_size(group) == 6);
+
+    // Batched components join the group as well, and the returned pointers stay valid.
+    EcsEntity batch[3] = { entities[0], entities[6], entities[9] };
+    void* components[3];
+    ecs_component_set_many(batch, 3, float_component, components);
+    for(int i = 0; i < 3; i++) {
+        ck_assert(components[i] == ecs_component_try_get(batch[i], float_component));
+        *(float*)components[i] = (float)batch[i].id;
+    }
+
+    ck_assert(ecs_component_group_size(group) == 9);
+    check_group(group, entities, 12);
+
+    ecs_component_remove_many(batch, 3, int_component);
+    ck_assert(ecs_component_group_size(group) == 6);
+    check_group(group, entities, 12);
+
+    ecs_component_group_free(group);
+}
+END_TEST
+
+START_TEST(group_rejects_unsupported_pools) {
+    EcsComponentManager* tag = ecs_component_define_tag();
+    EcsComponentManager* managers[] = { int_component, tag };
+    ck_assert_msg(ecs_component_group_init(world, managers, 2) == NULL, "Group owned a tag");
+
+    EcsEntity first = ecs_create_entity(world);
+    EcsEntity second = ecs_create_entity(world);
+    ecs_component_set(first, float_component);
+    ecs_component_set_same_as(second, first, float_component);
+    managers[1] = float_component;
+    ck_assert_msg(ecs_component_group_init(world, managers, 2) == NULL, "Group owned a pool with shared components");
+
+    managers[1] = int_component;
+    EcsComponentGroup* group = ecs_component_group_init(world, managers, 1);
+    ck_assert(group != NULL);
+    ck_assert_msg(ecs_component_group_init(world, managers, 1) == NULL, "Two groups owned the same pool");
+
+    ecs_component_set(first, int_component);
+    ck_assert(ecs_component_set_same_as(second, first, int_component) == ECS_RESULT_INVALID_STATE);
+
+    ecs_component_group_free(group);
+    ecs_component_free(tag);
+}
+END_TEST
+
+START_TEST(group_set_moves_other_owned_pools) {
+    EcsEntity first = ecs_create_entity(world);
+    EcsEntity second = ecs_create_entity(world);
+    EcsEntity third = ecs_create_entity(world);
+
+    *(int*)ecs_component_set(first, int_component) = 1;
+    *(float*)ecs_component_set(first, float_component) = 1;
+    *(float*)ecs_component_set(second, float_component) = 2;
+    *(float*)ecs_component_set(third, float_component) = 3;
+
+    EcsComponentManager* managers[] = { int_component, float_component };
+    EcsComponentGroup* group = ecs_component_group_init(world, managers, 2);
+    ck_assert(ecs_component_group_size(group) == 1);
+
+    float* second_float = ecs_component_try_get(second, float_component);
+    ck_assert(*second_float == 2);
+
+    // Only the int pool of the third entity is written to, but joining the group swaps its float
+    // with the float of the second entity.
+    *(int*)ecs_component_set(third, int_component) = 3;
+    ck_assert(ecs_component_group_size(group) == 2);
+    ck_assert_msg(ecs_component_try_get(second, float_component) != second_float, "Float component wasn't moved");
+    ck_assert(*second_float == 3);
+    ck_assert(*(float*)ecs_component_try_get(second, float_component) == 2);
+
+    ecs_component_group_free(group);
+}
+END_TEST
+
+START_TEST(group_is_detached_when_pool_is_freed) {
+    EcsComponentManager* temporary = ecs_component_define(sizeof(float), NULL, NULL);
+    EcsEntity entity = ecs_create_entity(world);
+    ecs_component_set(entity, int_component);
+    ecs_component_set(entity, temporary);
+
+    EcsComponentManager* managers[] = { int_component, temporary };
+    EcsComponentGroup* group = ecs_component_group_init(world, managers, 2);
+    ck_assert(ecs_component_group_size(group) == 1);
+
+    ecs_component_free(temporary);
+
+    int count;
+    ck_assert(ecs_component_group_size(group) == 0);
+    ck_assert(ecs_component_group_get_components(group, int_component, &count) == NULL);
+    ck_assert_msg(ecs_component_group_get_entity(group, 0).id == -1, "Detached group returned an entity");
+
+    ecs_component_group_free(group);
+}
+END_TEST
+
+int main(void) {
+    int number_failed;
+
+    Suite* s = suite_create("Component Group");
+    TCase* tc_group = tcase_create("Component Group");
+
+    tcase_add_unchecked_fixture(tc_group, group_setup, group_teardown);
+    tcase_add_checked_fixture(tc_group, group_start, group_stop);
+
+    tcase_add_test(tc_group, group_packs_existing_entities);
+    tcase_add_test(tc_group, group_follows_component_changes);
+    tcase_add_test(tc_group, group_rejects_unsupported_pools);
+    tcase_add_test(tc_group, group_set_moves_other_owned_pools);
+    tcase_add_test(tc_group, group_is_detached_when_pool_is_freed);
+
+    suite_add_tcase(s, tc_group);
+
+    SRunner* sr = srunner_create(s);
+
+    srunner_run_all(sr, CK_VERBOSE);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+
+    return number_failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
\ No newline at end of file
@@ -157,6 +157,384 @@ START_TEST(component_get_all) {
 }
 END_TEST
 
+START_TEST(chunked_component_does_not_move_on_growth) {
+    EcsComponentManager* manager = ecs_component_define_chunked(sizeof(int), 4, NULL, NULL);
+    EcsEntity entities[10];
+    int* first = NULL;
+    for(int i = 0; i < 10; ++i) {
+        entities[i] = ecs_create_entity(world);
+        int* value = ecs_component_set(entities[i], manager);
+        *value = i;
+        if(i == 0)
+            first = value;
+    }
+
+    int* current;
+    ck_assert(ecs_component_get(entities[0], manager, &current) == ECS_RESULT_SUCCESS);
+    ck_assert_msg(current == first, "Chunked component moved when the pool grew");
+    ck_assert(*first == 0);
+
+    for(int i = 0; i < 10; ++i)
+        ecs_entity_free(entities[i]);
+    ecs_component_free(manager);
+}
+END_TEST
+
+START_TEST(chunked_component_get_chunk) {
+    EcsComponentManager* manager = ecs_component_define_chunked(sizeof(int), 4, NULL, NULL);
+    EcsEntity entities[10];
+    for(int i = 0; i < 10; ++i) {
+        entities[i] = ecs_create_entity(world);
+        *(int*)ecs_component_set(entities[i], manager) = i;
+    }
+
+    int count;
+    int total = 0;
+    int* ints;
+    for(int chunk = 0; (ints = ecs_component_get_chunk(world, manager, chunk, &count)) != NULL; ++chunk) {
+        ck_assert(count <= 4);
+        for(int i = 0; i < count; ++i)
+            ck_assert(ints[i] == total + i);
+        total += count;
+    }
+    ck_assert_msg(total == 10, "Chunks did not contain every component");
+
+    // The components aren't contiguous, so getting all of them at once fails instead of returning the first chunk.
+    count = -1;
+    ck_assert_msg(ecs_component_get_all(world, manager, &count) == NULL && count == 0, "Chunked get_all returned a partial array");
+
+    // The smallest chunk holds two components.
+    EcsComponentManager* smallest = ecs_component_define_chunked(sizeof(int), 1, NULL, NULL);
+    for(int i = 0; i < 3; ++i)
+        ecs_component_set(entities[i], smallest);
+    ck_assert(ecs_component_get_chunk(world, smallest, 0, &count) != NULL && count == 2);
+
+    for(int i = 0; i < 10; ++i)
+        ecs_entity_free(entities[i]);
+    ecs_component_free(smallest);
+    ecs_component_free(manager);
+}
+END_TEST
+
+START_TEST(aligned_component_is_aligned_after_growth) {
+    // A 12 byte component with 32 byte alignment has to be padded to keep every element aligned.
+    EcsComponentManager* manager = ecs_component_define_aligned(12, 32, NULL, NULL);
+    EcsEntity entities[20];
+    for(int i = 0; i < 20; ++i) {
+        entities[i] = ecs_create_entity(world);
+        char* component = ecs_component_set(entities[i], manager);
+        ck_assert_msg(((uintptr_t)component & 31) == 0, "Component was not aligned");
+        *(int*)component = i;
+    }
+
+    int count;
+    char* components = ecs_component_get_all(world, manager, &count);
+    ck_assert(count == 20);
+    ck_assert(((uintptr_t)components & 31) == 0);
+    for(int i = 0; i < count; ++i)
+        ck_assert(*(int*)(components + i * 32) == i);
+
+    for(int i = 0; i < 20; ++i)
+        ecs_entity_free(entities[i]);
+    ecs_component_free(manager);
+}
+END_TEST
+
+START_TEST(tag_component_toggles_flag) {
+    EcsComponentManager* tag = ecs_component_define_tag();
+    EcsEntity entity = ecs_create_entity(world);
+
+    ck_assert(ecs_component_set(entity, tag) == NULL);
+    ck_assert(ecs_component_exists(entity, tag));
+    ck_assert(ecs_component_enum_get_flag(ecs_entity_get_components(entity), tag->flag));
+
+    int count;
+    ck_assert(ecs_component_get_all(world, tag, &count) == NULL && count == 0);
+
+    ck_assert(ecs_component_remove(entity, tag) == ECS_RESULT_SUCCESS);
+    ck_assert(!ecs_component_exists(entity, tag));
+    ck_assert(ecs_component_remove(entity, tag) == ECS_RESULT_INVALID_ENTITY);
+
+    ecs_component_set(entity, tag);
+    ecs_entity_free(entity);
+
+    // The id is reused, so the new entity must not inherit the tag.
+    entity = ecs_create_entity(world);
+    ck_assert(!ecs_component_exists(entity, tag));
+
+    ComponentFlag flag = tag->flag;
+    ecs_component_set(entity, tag);
+    ecs_component_free(tag);
+    ck_assert(!ecs_component_enum_get_flag(ecs_entity_get_components(entity), flag));
+    ecs_entity_free(entity);
+}
+END_TEST
+
+START_TEST(component_lookup_does_not_create_pool) {
+    EcsComponentManager* manager = ecs_component_define(sizeof(int), NULL, NULL);
+    EcsEntity entity = ecs_create_entity(world);
+
+    ck_assert(!ecs_component_has(entity, manager));
+    ck_assert(!ecs_component_exists(entity, manager));
+    ck_assert(ecs_component_try_get(entity, manager) == NULL);
+    ck_assert_msg(ecs_component_find_pool(world, manager) == NULL, "Lookup created a pool");
+
+    EcsComponentPool* pool = ecs_component_get_pool(world, manager);
+    ck_assert(pool != NULL && ecs_component_find_pool(world, manager) == pool);
+
+    int* value = ecs_component_set(entity, manager);
+    ck_assert(ecs_component_pool_has(pool, entity));
+    ck_assert(ecs_component_pool_get(pool, entity) == value);
+    ck_assert(ecs_component_try_get(entity, manager) == value);
+
+    ecs_entity_free(entity);
+    ck_assert(!ecs_component_pool_has(pool, entity));
+    ecs_component_free(manager);
+}
+END_TEST
+
+START_TEST(component_enum_spills_to_heap) {
+    ComponentEnum cenum = COMPONENT_ENUM_DEFAULT;
+    ComponentFlag low = ((ComponentFlag)1 << 32) | 4;
+    ComponentFlag high = ((ComponentFlag)(ECS_COMPONENT_ENUM_INLINE_WORDS + 2) << 32) | 8;
+
+    ecs_component_enum_set_flag(&cenum, low, true);
+    ck_assert(ecs_component_enum_get_flag(&cenum, low));
+    ck_assert(!ecs_component_enum_get_flag(&cenum, high));
+
+    ecs_component_enum_set_flag(&cenum, high, true);
+    ck_assert_msg(ecs_component_enum_get_flag(&cenum, low), "Inline flags were lost when moving to the heap");
+    ck_assert(ecs_component_enum_get_flag(&cenum, high));
+
+    ComponentEnum copy = ecs_component_enum_copy(&cenum);
+    ck_assert(ecs_component_enum_contains_enum(&copy, &cenum));
+
+    ecs_component_enum_clear(&cenum);
+    ck_assert(!ecs_component_enum_get_flag(&cenum, low));
+    ck_assert(!ecs_component_enum_get_flag(&cenum, high));
+    ck_assert(ecs_component_enum_get_flag(&copy, high));
+    ck_assert(ecs_component_enum_not_contains_enum(&cenum, &copy));
+
+    ecs_component_enum_free_resources(&cenum);
+    ecs_component_enum_free_resources(&copy);
+}
+END_TEST
+
+START_TEST(component_enum_match_many_matches_each_signature) {
+    ComponentFlag flags[] = {
+        ((ComponentFlag)0 << 32) | 1,
+        ((ComponentFlag)0 << 32) | 0x80000000,
+        ((ComponentFlag)1 << 32) | 2,
+        ((ComponentFlag)(ECS_COMPONENT_ENUM_INLINE_WORDS - 1) << 32) | 4,
+        ((ComponentFlag)(ECS_COMPONENT_ENUM_INLINE_WORDS + 1) << 32) | 8
+    };
+
+    ComponentEnum with = COMPONENT_ENUM_DEFAULT;
+    ComponentEnum without = COMPONENT_ENUM_DEFAULT;
+    ecs_component_enum_set_flag(&with, flags[0], true);
+    ecs_component_enum_set_flag(&with, flags[3], true);
+    ecs_component_enum_set_flag(&without, flags[2], true);
+
+    // Every combination of the flags, repeated so the mask spans more than one word.
+    ComponentEnum signatures[100];
+    for(int i = 0; i < 100; i++) {
+        signatures[i] = COMPONENT_ENUM_DEFAULT;
+        for(int flag = 0; flag < 5; flag++) {
+            if((i >> flag) & 1)
+                ecs_component_enum_set_flag(signatures + i, flags[flag], true);
+        }
+    }
+
+    uint64_t mask[2];
+    int matches = ecs_component_enum_match_many(signatures, 100, &with, &without, mask);
+
+    int expected = 0;
+    for(int i = 0; i < 100; i++) {
+        bool match = ecs_component_enum_contains_enum(signatures + i, &with) && ecs_component_enum_not_contains_enum(signatures + i, &without);
+        expected += match;
+        ck_assert_msg(((mask[i / 64] >> (i % 64)) & 1) == match, "Signature %d was matched incorrectly", i);
+    }
+    ck_assert(matches == expected);
+
+    // Filters stored on the heap take the slow path but must give the same result.
+    ecs_component_enum_set_flag(&without, flags[4], true);
+    matches = ecs_component_enum_match_many(signatures, 100, &with, &without, mask);
+    for(int i = 0; i < 100; i++) {
+        bool match = ecs_component_enum_contains_enum(signatures + i, &with) && ecs_component_enum_not_contains_enum(signatures + i, &without);
+        ck_assert(((mask[i / 64] >> (i % 64)) & 1) == match);
+    }
+
+    for(int i = 0; i < 100; i++)
+        ecs_component_enum_free_resources(signatures + i);
+    ecs_component_enum_free_resources(&with);
+    ecs_component_enum_free_resources(&without);
+}
+END_TEST
+
+START_TEST(shared_component_survives_owner_removal) {
+    EcsEntity owner = ecs_create_entity(world);
+    EcsEntity sharer1 = ecs_create_entity(world);
+    EcsEntity sharer2 = ecs_create_entity(world);
+    int** value = ecs_component_set(owner, number_pointer_component);
+    ck_assert(ecs_component_set_same_as(sharer1, owner, number_pointer_component) == ECS_RESULT_SUCCESS);
+    ck_assert(ecs_component_set_same_as(sharer2, owner, number_pointer_component) == ECS_RESULT_SUCCESS);
+
+    int* expected = *value;
+    ecs_component_remove(owner, number_pointer_component);
+    ck_assert_msg(numbers_freed == 0, "Shared component destroyed while still referenced");
+
+    int** shared;
+    ck_assert(ecs_component_get(sharer1, number_pointer_component, &shared) == ECS_RESULT_SUCCESS);
+    ck_assert(*shared == expected);
+    ck_assert(ecs_component_get(sharer2, number_pointer_component, &shared) == ECS_RESULT_SUCCESS);
+    ck_assert(*shared == expected);
+
+    ecs_component_remove(sharer1, number_pointer_component);
+    ecs_component_remove(sharer2, number_pointer_component);
+    ck_assert_msg(numbers_freed == 1, "Shared component not destroyed exactly once");
+
+    ecs_entity_free(owner);
+    ecs_entity_free(sharer1);
+    ecs_entity_free(sharer2);
+}
+END_TEST
+
+START_TEST(shared_component_moves_with_swap_remove) {
+    EcsEntity first = ecs_create_entity(world);
+    EcsEntity owner = ecs_create_entity(world);
+    EcsEntity sharer = ecs_create_entity(world);
+    *(int*)ecs_component_set(first, number_component) = 1;
+    *(int*)ecs_component_set(owner, number_component) = 2;
+    ecs_component_set_same_as(sharer, owner, number_component);
+
+    // Removing the first component moves the shared component into its slot.
+    ecs_component_remove(first, number_component);
+
+    int* value;
+    ck_assert(ecs_component_get(owner, number_component, &value) == ECS_RESULT_SUCCESS);
+    ck_assert(*value == 2);
+    ck_assert(ecs_component_get(sharer, number_component, &value) == ECS_RESULT_SUCCESS);
+    ck_assert(*value == 2);
+
+    int count;
+    ecs_component_get_all(world, number_component, &count);
+    ck_assert(count == 1);
+
+    ecs_entity_free(first);
+    ecs_entity_free(owner);
+    ecs_entity_free(sharer);
+}
+END_TEST
+
+static int compare_numbers(const void* left, const void* right) {
+    int a = *(const int*)left;
+    int b = *(const int*)right;
+    return a < b ? -1 : a > b;
+}
+
+static uint32_t number_key(const void* component) {
+    return ecs_component_sort_key_float((float)*(const int*)component / 2.0f);
+}
+
+// Checks that the components of number_component are sorted and still belong to the same entities.
+static void check_sorted_numbers(EcsEntity* entities, int* values, int entity_count) {
+    int count;
+    int* numbers = ecs_component_get_all(world, number_component, &count);
+    for(int i = 1; i < count; i++)
+        ck_assert_msg(numbers[i - 1] <= numbers[i], "Components weren't sorted");
+
+    for(int i = 0; i < entity_count; i++) {
+        int* value;
+        ck_assert(ecs_component_get(entities[i], number_component, &value) == ECS_RESULT_SUCCESS);
+        ck_assert_msg(*value == values[i], "Entity lost its component while sorting");
+    }
+}
+
+START_TEST(component_sort_keeps_owners) {
+    EcsEntity entities[33];
+    int values[33];
+    for(int i = 0; i < 32; i++) {
+        entities[i] = ecs_create_entity(world);
+        values[i] = ((i * 7919) % 61) - 30;
+        *(int*)ecs_component_set(entities[i], number_component) = values[i];
+    }
+
+    // Shared components are moved through their share slot.
+    entities[32] = ecs_create_entity(world);
+    values[32] = values[5];
+    ecs_component_set_same_as(entities[32], entities[5], number_component);
+
+    ck_assert(ecs_component_sort(world, number_component, compare_numbers) == ECS_RESULT_SUCCESS);
+    check_sorted_numbers(entities, values, 33);
+
+    // Move a few components out of place, then fix them up incrementally.
+    int* value;
+    ecs_component_get(entities[3], number_component, &value);
+    *value = values[3] = 100;
+    ecs_component_get(entities[20], number_component, &value);
+    *value = values[20] = -100;
+    ck_assert(ecs_component_sort_incremental(world, number_component, compare_numbers) == ECS_RESULT_SUCCESS);
+    check_sorted_numbers(entities, values, 33);
+
+    ecs_component_get(entities[9], number_component, &value);
+    *value = values[9] = -50;
+    ck_assert(ecs_component_sort_by_key(world, number_component, number_key) == ECS_RESULT_SUCCESS);
+    check_sorted_numbers(entities, values, 33);
+}
+END_TEST
+
+START_TEST(component_sort_rejects_grouped_pool) {
+    EcsEntity entity = ecs_create_entity(world);
+    ecs_component_set(entity, number_component);
+
+    EcsComponentGroup* group = ecs_component_group_init(world, &number_component, 1);
+    ck_assert(ecs_component_sort(world, number_component, compare_numbers) == ECS_RESULT_INVALID_STATE);
+    ecs_component_group_free(group);
+
+    ck_assert(ecs_component_sort(world, number_component, compare_numbers) == ECS_RESULT_SUCCESS);
+}
+END_TEST
+
+static int many_count;
+
+static void count_added_many(void* data, EcsComponentAddedManyMessage* message) {
+    many_count += message->count;
+}
+
+static void count_removed_many(void* data, EcsComponentRemovedManyMessage* message) {
+    many_count += message->count;
+}
+
+START_TEST(component_many_reports_changed_entities) {
+    EcsComponentManager* tag = ecs_component_define_tag();
+    int added = ecs_event_subscribe(world, ecs_component_get_added_many_event(tag), ecs_closure(NULL, count_added_many));
+    int removed = ecs_event_subscribe(world, ecs_component_get_removed_many_event(number_component),
+                                      ecs_closure(NULL, count_removed_many));
+
+    EcsEntity first = ecs_create_entity(world);
+    EcsEntity second = ecs_create_entity(world);
+    ecs_component_set(first, tag);
+
+    // The first entity already has the tag and the second one is passed twice.
+    EcsEntity tagged[] = { first, second, second };
+    many_count = 0;
+    ecs_component_set_many(tagged, 3, tag, NULL);
+    ck_assert_msg(many_count == 1, "Tag set reported unchanged entities");
+    ck_assert(ecs_component_exists(second, tag));
+
+    ecs_component_set(first, number_component);
+    EcsEntity numbers[] = { first, first, second };
+    many_count = 0;
+    ecs_component_remove_many(numbers, 3, number_component);
+    ck_assert_msg(many_count == 1, "Remove reported an entity more than once");
+    ck_assert(!ecs_component_exists(first, number_component));
+
+    ecs_event_unsubscribe(world, ecs_component_get_removed_many_event(number_component), removed);
+    ecs_event_unsubscribe(world, ecs_component_get_added_many_event(tag), added);
+    ecs_component_free(tag);
+}
+END_TEST
+
 int main(void) {
     int number_failed;
 
@@ -176,6 +554,18 @@ int main(void) {
     tcase_add_test(tc_component, entity_free_removes_components);
     tcase_add_test(tc_component, component_free_destroys_all_components);
     tcase_add_test(tc_component, component_get_all);
+    tcase_add_test(tc_component, chunked_component_does_not_move_on_growth);
+    tcase_add_test(tc_component, chunked_component_get_chunk);
+    tcase_add_test(tc_component, aligned_component_is_aligned_after_growth);
+    tcase_add_test(tc_component, tag_component_toggles_flag);
+    tcase_add_test(tc_component, component_lookup_does_not_create_pool);
+    tcase_add_test(tc_component, component_enum_spills_to_heap);
+    tcase_add_test(tc_component, component_enum_match_many_matches_each_signature);
+    tcase_add_test(tc_component, shared_component_survives_owner_removal);
+    tcase_add_test(tc_component, shared_component_moves_with_swap_remove);
+    tcase_add_test(tc_component, component_sort_keeps_owners);
+    tcase_add_test(tc_component, component_sort_rejects_grouped_pool);
+    tcase_add_test(tc_component, component_many_reports_changed_entities);
 
     suite_add_tcase(s, tc_component);
 
@@ -0,0 +1,79 @@
+#include <stdlib.h>
+
+#include "check.h"
+#include "ecs.h"
+
+static EcsComponentManager* int_component;
+
+void context_setup(void) {
+    ecs_init();
+    int_component = ecs_component_define(sizeof(int), NULL, NULL);
+}
+
+void context_teardown(void) {
+    ecs_component_free(int_component);
+}
+
+START_TEST(context_is_current_while_set) {
+    EcsContext* context = ecs_context_init();
+    ck_assert_msg(ecs_context_get_current() != context, "New context was made current");
+
+    ecs_context_set_current(context);
+    ck_assert_msg(ecs_context_get_current() == context, "Context wasn't made current");
+
+    ecs_context_set_current(NULL);
+    ck_assert_msg(ecs_context_get_current() != context, "Context wasn't replaced by the default context");
+
+    ecs_context_free(context);
+}
+END_TEST
+
+START_TEST(contexts_do_not_share_worlds) {
+    EcsWorld world = ecs_world_init();
+    EcsEntity entity = ecs_create_entity(world);
+    *(int*)ecs_component_set(entity, int_component) = 3;
+
+    EcsContext* context = ecs_context_init();
+    ecs_context_set_current(context);
+
+    // The other context has its own world table, so the world ids overlap.
+    EcsComponentManager* other_component = ecs_component_define(sizeof(int), NULL, NULL);
+    EcsWorld other_world = ecs_world_init();
+    ck_assert_msg(other_world == world, "Contexts share world ids");
+
+    EcsEntity other = ecs_create_entity(other_world);
+    *(int*)ecs_component_set(other, other_component) = 5;
+    ck_assert(*(int*)ecs_component_try_get(other, other_component) == 5);
+
+    ecs_world_free(other_world);
+    ecs_component_free(other_component);
+    ecs_context_set_current(NULL);
+    ecs_context_free(context);
+
+    ck_assert_msg(ecs_entity_is_alive(entity), "Freeing a world in another context freed the entity");
+    ck_assert_msg(*(int*)ecs_component_try_get(entity, int_component) == 3, "Component was changed by another context");
+    ecs_world_free(world);
+}
+END_TEST
+
+int main(void) {
+    int number_failed;
+
+    Suite* s = suite_create("ECS Contexts");
+    TCase* tc_context = tcase_create("ECS Contexts");
+
+    tcase_add_unchecked_fixture(tc_context, context_setup, context_teardown);
+
+    tcase_add_test(tc_context, context_is_current_while_set);
+    tcase_add_test(tc_context, contexts_do_not_share_worlds);
+
+    suite_add_tcase(s, tc_context);
+
+    SRunner* sr = srunner_create(s);
+
+    srunner_run_all(sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+
+    return number_failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
\ No newline at end of file
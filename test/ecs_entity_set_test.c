@@ -149,6 +149,365 @@ START_TEST(set_should_not_include_disabled_entity) {
 }
 END_TEST
 
+START_TEST(set_updates_with_batched_components) {
+    EcsEntitySetBuilder* builder = ecs_entity_set_builder_init();
+    ecs_entity_set_with(builder, bool_component);
+    ecs_entity_set_without(builder, int_component);
+    EcsEntitySet* set = ecs_entity_set_build(builder, world, true);
+
+    EcsEntity entities[8];
+    for(int i = 0; i < 8; i++)
+        entities[i] = ecs_create_entity(world);
+
+    bool* values[8];
+    ck_assert(ecs_component_set_many(entities, 8, bool_component, (void**)values) == ECS_RESULT_SUCCESS);
+    for(int i = 0; i < 8; i++)
+        ck_assert(ecs_component_exists(entities[i], bool_component));
+
+    int set_count;
+    ecs_entity_set_get_entities(set, &set_count);
+    ck_assert_msg(set_count == 8, "Set missed batched component additions");
+
+    ecs_component_set_many(entities, 3, int_component, NULL);
+    ecs_entity_set_get_entities(set, &set_count);
+    ck_assert_msg(set_count == 5, "Set kept entities with a batched without component");
+
+    ecs_component_remove_many(entities, 3, int_component);
+    ecs_entity_set_get_entities(set, &set_count);
+    ck_assert_msg(set_count == 8, "Set missed batched without component removal");
+
+    ecs_component_remove_many(entities + 4, 4, bool_component);
+    ecs_entity_set_get_entities(set, &set_count);
+    ck_assert_msg(set_count == 4, "Set kept entities after batched removal");
+    ck_assert(!ecs_component_exists(entities[5], bool_component));
+
+    ecs_entity_set_free(set);
+}
+END_TEST
+
+START_TEST(set_updates_with_tag_components) {
+    EcsComponentManager* tag = ecs_component_define_tag();
+
+    EcsEntitySetBuilder* builder = ecs_entity_set_builder_init();
+    ecs_entity_set_with(builder, tag);
+    EcsEntitySet* set = ecs_entity_set_build(builder, world, true);
+
+    EcsEntity tagged = ecs_create_entity(world);
+    EcsEntity untagged = ecs_create_entity(world);
+    ecs_component_set(tagged, tag);
+
+    int set_count;
+    EcsEntity* entities = ecs_entity_set_get_entities(set, &set_count);
+    ck_assert_msg(set_count == 1 && entities[0].id == tagged.id, "Set did not include the tagged entity");
+
+    ecs_component_remove(tagged, tag);
+    ecs_entity_set_get_entities(set, &set_count);
+    ck_assert_msg(set_count == 0, "Set did not remove the untagged entity");
+
+    ecs_component_set(untagged, tag);
+    ecs_entity_free(untagged);
+    ecs_entity_set_get_entities(set, &set_count);
+    ck_assert_msg(set_count == 0, "Set kept a freed entity");
+
+    ecs_entity_set_free(set);
+    ecs_component_free(tag);
+}
+END_TEST
+
+START_TEST(set_in_scan_mode_matches_world) {
+    EcsEntitySetBuilder* builder = ecs_entity_set_builder_init();
+    ecs_entity_set_with(builder, int_component);
+    ecs_entity_set_without(builder, bool_component);
+    EcsEntitySet* set = ecs_entity_set_build(builder, world, true);
+    ecs_entity_set_set_mode(set, ECS_ENTITY_SET_MODE_SCAN, false);
+
+    EcsEntity entities[8];
+    for(int i = 0; i < 8; i++) {
+        entities[i] = ecs_create_entity(world);
+        ecs_component_set(entities[i], int_component);
+        if(i % 2 == 0)
+            ecs_component_set(entities[i], bool_component);
+    }
+
+    int set_count;
+    EcsEntity* result = ecs_entity_set_get_entities(set, &set_count);
+    ck_assert_msg(set_count == 4, "Scanned set has the wrong number of entities");
+    for(int i = 0; i < set_count; i++)
+        ck_assert_msg(result[i].id % 2 == 1, "Scanned set included an entity without the components");
+
+    EcsEntitySetStats stats = ecs_entity_set_get_stats(set);
+    ck_assert(stats.mode == ECS_ENTITY_SET_MODE_SCAN);
+    ck_assert_msg(stats.scanned == 8, "Set didn't scan the world");
+
+    // The set isn't scanned again unless it changed.
+    ecs_entity_set_get_entities(set, &set_count);
+    ck_assert_msg(ecs_entity_set_get_stats(set).scanned == 0, "Unchanged set was scanned");
+
+    ecs_entity_disable(entities[1]);
+    ecs_component_remove(entities[2], bool_component);
+    ecs_entity_set_get_entities(set, &set_count);
+    ck_assert_msg(set_count == 4, "Scanned set didn't see the changes");
+
+    // Switching back rebuilds the mapping so the set can be maintained by events again.
+    ecs_entity_set_set_mode(set, ECS_ENTITY_SET_MODE_MAINTAINED, false);
+    ecs_component_remove(entities[3], int_component);
+    ecs_entity_set_get_entities(set, &set_count);
+    ck_assert_msg(set_count == 3, "Maintained set didn't remove an entity after switching modes");
+
+    ecs_entity_set_free(set);
+}
+END_TEST
+
+START_TEST(adaptive_set_switches_modes) {
+    EcsEntitySetBuilder* builder = ecs_entity_set_builder_init();
+    ecs_entity_set_with(builder, int_component);
+    EcsEntitySet* set = ecs_entity_set_build(builder, world, true);
+
+    EcsEntity entities[4];
+    for(int i = 0; i < 4; i++)
+        entities[i] = ecs_create_entity(world);
+
+    // Every frame changes each entity much more than it would cost to scan the world.
+    int set_count;
+    for(int frame = 0; frame < ECS_ENTITY_SET_ADAPT_FRAMES; frame++) {
+        ck_assert(ecs_entity_set_get_stats(set).mode == ECS_ENTITY_SET_MODE_MAINTAINED);
+        for(int i = 0; i < 4; i++) {
+            ecs_component_set(entities[i], int_component);
+            ecs_component_remove(entities[i], int_component);
+            ecs_component_set(entities[i], int_component);
+        }
+        ecs_entity_set_get_entities(set, &set_count);
+    }
+
+    EcsEntitySetStats stats = ecs_entity_set_get_stats(set);
+    ck_assert_msg(stats.mode == ECS_ENTITY_SET_MODE_SCAN, "Churning set didn't switch to scan mode");
+    ck_assert(stats.switches == 1);
+
+    // Once the changes stop, the set goes back to being maintained.
+    for(int frame = 0; frame < ECS_ENTITY_SET_ADAPT_FRAMES; frame++)
+        ecs_entity_set_get_entities(set, &set_count);
+
+    stats = ecs_entity_set_get_stats(set);
+    ck_assert_msg(stats.mode == ECS_ENTITY_SET_MODE_MAINTAINED, "Quiet set didn't switch back");
+    ck_assert(stats.switches == 2);
+    ck_assert_msg(set_count == 4, "Set lost entities while switching modes");
+
+    ecs_entity_set_free(set);
+}
+END_TEST
+
+START_TEST(shared_adaptive_set_switches_modes) {
+    EcsEntitySet* owners[2];
+    for(int i = 0; i < 2; i++) {
+        EcsEntitySetBuilder* builder = ecs_entity_set_builder_init();
+        ecs_entity_set_with(builder, int_component);
+        owners[i] = ecs_entity_set_build(builder, world, true);
+    }
+    ck_assert(owners[0] == owners[1]);
+
+    EcsEntity entities[4];
+    for(int i = 0; i < 4; i++)
+        entities[i] = ecs_create_entity(world);
+
+    // The second owner of each frame doesn't see any new changes, which mustn't hide the churn of the frame.
+    int set_count;
+    for(int frame = 0; frame < ECS_ENTITY_SET_ADAPT_FRAMES; frame++) {
+        for(int i = 0; i < 4; i++) {
+            ecs_component_set(entities[i], int_component);
+            ecs_component_remove(entities[i], int_component);
+            ecs_component_set(entities[i], int_component);
+        }
+        ecs_entity_set_get_entities(owners[0], &set_count);
+        ecs_entity_set_get_entities(owners[1], &set_count);
+    }
+
+    EcsEntitySetStats stats = ecs_entity_set_get_stats(owners[0]);
+    ck_assert_msg(stats.mode == ECS_ENTITY_SET_MODE_SCAN, "Churning shared set didn't switch to scan mode");
+    ck_assert(stats.switches == 1);
+
+    for(int frame = 0; frame < ECS_ENTITY_SET_ADAPT_FRAMES; frame++) {
+        ecs_entity_set_get_entities(owners[0], &set_count);
+        ecs_entity_set_get_entities(owners[1], &set_count);
+    }
+
+    stats = ecs_entity_set_get_stats(owners[1]);
+    ck_assert_msg(stats.mode == ECS_ENTITY_SET_MODE_MAINTAINED, "Quiet shared set didn't switch back");
+    ck_assert(stats.switches == 2);
+    ck_assert(set_count == 4);
+
+    ecs_entity_set_free(owners[0]);
+    ecs_entity_set_free(owners[1]);
+}
+END_TEST
+
+START_TEST(sets_sharing_components_update_independently) {
+    EcsEntitySetBuilder* builder = ecs_entity_set_builder_init();
+    ecs_entity_set_with(builder, int_component);
+    EcsEntitySet* with_int = ecs_entity_set_build(builder, world, false);
+    ecs_entity_set_without(builder, bool_component);
+    EcsEntitySet* only_int = ecs_entity_set_build(builder, world, true);
+
+    builder = ecs_entity_set_builder_init();
+    ecs_entity_set_with(builder, int_component);
+    ecs_entity_set_with(builder, bool_component);
+    EcsEntitySet* with_both = ecs_entity_set_build(builder, world, true);
+
+    EcsEntity entities[4];
+    for(int i = 0; i < 4; i++) {
+        entities[i] = ecs_create_entity(world);
+        ecs_component_set(entities[i], int_component);
+    }
+    ecs_component_set(entities[0], bool_component);
+
+    int set_count;
+    ecs_entity_set_get_entities(with_int, &set_count);
+    ck_assert_msg(set_count == 4, "First set missed entities");
+    ecs_entity_set_get_entities(only_int, &set_count);
+    ck_assert_msg(set_count == 3, "Set without a component included an entity with it");
+
+    // The remaining sets still listen to the component after one of them is freed.
+    ecs_entity_set_free(with_both);
+    ecs_component_remove(entities[1], int_component);
+    ecs_component_remove(entities[0], bool_component);
+
+    ecs_entity_set_get_entities(with_int, &set_count);
+    ck_assert_msg(set_count == 3, "First set didn't update after another set was freed");
+    ecs_entity_set_get_entities(only_int, &set_count);
+    ck_assert_msg(set_count == 3, "Set without a component didn't update after another set was freed");
+
+    ecs_entity_set_free(with_int);
+    ecs_entity_set_free(only_int);
+}
+END_TEST
+
+START_TEST(set_can_be_freed_after_world) {
+    EcsWorld other = ecs_world_init();
+
+    EcsEntitySetBuilder* builder = ecs_entity_set_builder_init();
+    ecs_entity_set_with(builder, int_component);
+    EcsEntitySet* set = ecs_entity_set_build(builder, other, true);
+    ecs_component_set(ecs_create_entity(other), int_component);
+
+    ecs_world_free(other);
+    ecs_entity_set_free(set);
+}
+END_TEST
+
+START_TEST(identical_builders_share_a_set) {
+    EcsEntitySetBuilder* builder = ecs_entity_set_builder_init();
+    ecs_entity_set_with(builder, int_component);
+    ecs_entity_set_without(builder, bool_component);
+    EcsEntitySet* first = ecs_entity_set_build(builder, world, true);
+
+    // The order the components are added in doesn't matter.
+    builder = ecs_entity_set_builder_init();
+    ecs_entity_set_without(builder, bool_component);
+    ecs_entity_set_with(builder, int_component);
+    EcsEntitySet* second = ecs_entity_set_build(builder, world, true);
+    ck_assert_msg(first == second, "Identical builders built separate sets");
+
+    builder = ecs_entity_set_builder_init();
+    ecs_entity_set_with(builder, int_component);
+    EcsEntitySet* different = ecs_entity_set_build(builder, world, true);
+    ck_assert_msg(different != first, "Different builders shared a set");
+
+    EcsEntity entity = ecs_create_entity(world);
+    ecs_component_set(entity, int_component);
+
+    // The shared set stays alive until both owners free it.
+    int set_count;
+    ecs_entity_set_free(first);
+    ecs_entity_set_get_entities(second, &set_count);
+    ck_assert_msg(set_count == 1, "Shared set was freed while it still had an owner");
+
+    ecs_component_set(entity, bool_component);
+    ecs_entity_set_get_entities(second, &set_count);
+    ck_assert_msg(set_count == 0, "Shared set stopped updating after an owner freed it");
+
+    ecs_entity_set_free(second);
+    ecs_entity_set_free(different);
+}
+END_TEST
+
+static void sum_components(void* data, EcsEntity entity, void** components) {
+    int* sum = data;
+    ck_assert(components[0] == ecs_component_try_get(entity, int_component));
+    *sum += *(int*)components[0];
+    if(*(bool*)components[1])
+        *sum += 100;
+}
+
+static void sum_component_batch(void* data, EcsEntity* entities, void** components, int count) {
+    int* sum = data;
+    ck_assert(count <= 3);
+    for(int i = 0; i < count; i++) {
+        ck_assert(components[i] == ecs_component_try_get(entities[i], int_component));
+        *sum += *(int*)components[i];
+        if(*(bool*)components[count + i])
+            *sum += 100;
+    }
+}
+
+START_TEST(set_each_gets_components) {
+    EcsEntitySetBuilder* builder = ecs_entity_set_builder_init();
+    ecs_entity_set_with(builder, int_component);
+    ecs_entity_set_with(builder, bool_component);
+    EcsEntitySet* set = ecs_entity_set_build(builder, world, true);
+
+    for(int i = 0; i < 8; i++) {
+        EcsEntity entity = ecs_create_entity(world);
+        *(int*)ecs_component_set(entity, int_component) = i;
+        *(bool*)ecs_component_set(entity, bool_component) = i == 0;
+    }
+
+    EcsComponentManager* managers[] = { int_component, bool_component };
+
+    int sum = 0;
+    ecs_entity_set_each(set, managers, 2, sum_components, &sum);
+    ck_assert_msg(sum == 128, "Each passed the wrong components");
+
+    sum = 0;
+    ecs_entity_set_each_batch(set, managers, 2, 3, sum_component_batch, &sum);
+    ck_assert_msg(sum == 128, "Each batch passed the wrong components");
+
+    ecs_entity_set_free(set);
+}
+END_TEST
+
+START_TEST(set_is_seeded_from_smallest_pool) {
+    EcsEntity entities[16];
+    for(int i = 0; i < 16; i++) {
+        entities[i] = ecs_create_entity(world);
+        ecs_component_set(entities[i], int_component);
+    }
+
+    ecs_component_set(entities[3], bool_component);
+    ecs_component_set_same_as(entities[5], entities[3], bool_component);
+    ecs_component_set_same_as(entities[9], entities[3], bool_component);
+    ecs_component_set(entities[12], bool_component);
+    ecs_entity_disable(entities[12]);
+
+    EcsEntitySetBuilder* builder = ecs_entity_set_builder_init();
+    ecs_entity_set_with(builder, int_component);
+    ecs_entity_set_with(builder, bool_component);
+    EcsEntitySet* set = ecs_entity_set_build(builder, world, true);
+
+    // Every entity that shares the component is found, but the disabled entity isn't.
+    int set_count;
+    EcsEntity* result = ecs_entity_set_get_entities(set, &set_count);
+    ck_assert_msg(set_count == 3, "Seeded set has the wrong number of entities");
+    for(int i = 0; i < set_count; i++)
+        ck_assert(result[i].id == entities[3].id || result[i].id == entities[5].id || result[i].id == entities[9].id);
+
+    // The set is still maintained by events after being seeded.
+    ecs_component_remove(entities[5], bool_component);
+    ecs_entity_set_get_entities(set, &set_count);
+    ck_assert_msg(set_count == 2, "Seeded set didn't remove an entity");
+
+    ecs_entity_set_free(set);
+}
+END_TEST
+
 int main(void) {
     int number_failed;
 
@@ -163,6 +522,16 @@ int main(void) {
     tcase_add_test(tc_eb, set_without_component_returns_all_entities_without_component);
     tcase_add_test(tc_eb, set_includes_previously_created_entity);
     tcase_add_test(tc_eb, set_should_not_include_disabled_entity);
+    tcase_add_test(tc_eb, set_updates_with_batched_components);
+    tcase_add_test(tc_eb, set_updates_with_tag_components);
+    tcase_add_test(tc_eb, set_in_scan_mode_matches_world);
+    tcase_add_test(tc_eb, adaptive_set_switches_modes);
+    tcase_add_test(tc_eb, shared_adaptive_set_switches_modes);
+    tcase_add_test(tc_eb, sets_sharing_components_update_independently);
+    tcase_add_test(tc_eb, set_can_be_freed_after_world);
+    tcase_add_test(tc_eb, identical_builders_share_a_set);
+    tcase_add_test(tc_eb, set_each_gets_components);
+    tcase_add_test(tc_eb, set_is_seeded_from_smallest_pool);
 
     suite_add_tcase(s, tc_eb);
 
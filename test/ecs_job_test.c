@@ -0,0 +1,90 @@
+#include <stdlib.h>
+
+#include "check.h"
+#include "ecs.h"
+
+#define JOB_ITEM_COUNT 10007
+
+static int visits[JOB_ITEM_COUNT];
+static int worker_indices[JOB_ITEM_COUNT];
+
+void job_start(void) {
+    for(int i = 0; i < JOB_ITEM_COUNT; ++i) {
+        visits[i] = 0;
+        worker_indices[i] = -1;
+    }
+}
+
+void visit_range(void* data, int start, int end) {
+    for(int i = start; i < end; ++i) {
+        visits[i]++;
+        worker_indices[i] = ecs_job_get_worker_index();
+    }
+}
+
+static void assert_visited_once(int count) {
+    for(int i = 0; i < count; ++i)
+        ck_assert_msg(visits[i] == 1, "Item %d was visited %d times", i, visits[i]);
+}
+
+START_TEST(parallel_for_visits_each_item_once) {
+    EcsJobPool* pool = ecs_job_pool_init(3);
+    ck_assert(pool != NULL);
+    ck_assert(ecs_job_pool_get_thread_count(pool) == 3);
+
+    ecs_job_pool_parallel_for(pool, JOB_ITEM_COUNT, 64, visit_range, NULL);
+    assert_visited_once(JOB_ITEM_COUNT);
+
+    for(int i = 0; i < JOB_ITEM_COUNT; ++i)
+        ck_assert_msg(worker_indices[i] >= 0 && worker_indices[i] <= 3, "Invalid worker index");
+
+    ecs_job_pool_free(pool);
+}
+END_TEST
+
+START_TEST(parallel_for_picks_grain_size) {
+    EcsJobPool* pool = ecs_job_pool_init(2);
+
+    // Run several loops on the same pool to make sure the workers pick up each one.
+    for(int i = 0; i < 3; ++i)
+        ecs_job_pool_parallel_for(pool, JOB_ITEM_COUNT, 0, visit_range, NULL);
+
+    for(int i = 0; i < JOB_ITEM_COUNT; ++i)
+        ck_assert_msg(visits[i] == 3, "Item %d was visited %d times", i, visits[i]);
+
+    ecs_job_pool_free(pool);
+}
+END_TEST
+
+START_TEST(parallel_for_without_pool_runs_on_caller) {
+    ecs_job_pool_parallel_for(NULL, 100, 7, visit_range, NULL);
+    assert_visited_once(100);
+    ck_assert(visits[100] == 0);
+
+    for(int i = 0; i < 100; ++i)
+        ck_assert_msg(worker_indices[i] == 0, "Loop without a pool ran on a worker");
+}
+END_TEST
+
+int main(void) {
+    int number_failed;
+
+    Suite* s = suite_create("ECS Jobs");
+    TCase* tc_job = tcase_create("ECS Jobs");
+
+    tcase_add_checked_fixture(tc_job, job_start, NULL);
+
+    tcase_add_test(tc_job, parallel_for_visits_each_item_once);
+    tcase_add_test(tc_job, parallel_for_picks_grain_size);
+    tcase_add_test(tc_job, parallel_for_without_pool_runs_on_caller);
+
+    suite_add_tcase(s, tc_job);
+
+    SRunner* sr = srunner_create(s);
+
+    srunner_run_all(sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+
+    return number_failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
\ No newline at end of file
@@ -0,0 +1,102 @@
+#include <stdlib.h>
+
+#include "check.h"
+#include "ecs.h"
+
+START_TEST(sparse_map_missing_id) {
+    EcsSparseMap map;
+    ecs_sparse_map_init(&map);
+    ck_assert_msg(ecs_sparse_map_get(&map, 0) == -1, "Empty map returned a value");
+    ck_assert_msg(ecs_sparse_map_get(&map, 2000000) == -1, "Empty map returned a value for a large id");
+    ecs_sparse_map_set(&map, 5, 3);
+    ck_assert_msg(ecs_sparse_map_get(&map, 6) == -1, "Map returned a value for an unset id");
+    ecs_sparse_map_free_resources(&map);
+}
+END_TEST
+
+START_TEST(sparse_map_set_get_remove) {
+    EcsSparseMap map;
+    ecs_sparse_map_init(&map);
+    ecs_sparse_map_set(&map, 2000000, 0);
+    ecs_sparse_map_set(&map, 7, 12);
+    ck_assert(ecs_sparse_map_get(&map, 2000000) == 0);
+    ck_assert(ecs_sparse_map_get(&map, 7) == 12);
+    ecs_sparse_map_remove(&map, 2000000);
+    ck_assert_msg(ecs_sparse_map_get(&map, 2000000) == -1, "Map did not remove id");
+    ck_assert(ecs_sparse_map_get(&map, 7) == 12);
+    ecs_sparse_map_free_resources(&map);
+}
+END_TEST
+
+START_TEST(sparse_map_next_skips_empty_pages) {
+    EcsSparseMap map;
+    ecs_sparse_map_init(&map);
+    ecs_sparse_map_set(&map, 3, 1);
+    ecs_sparse_map_set(&map, ECS_SPARSE_PAGE_SIZE * 5 + 1, 2);
+    ck_assert(ecs_sparse_map_next(&map, 0) == 3);
+    ck_assert(ecs_sparse_map_next(&map, 4) == ECS_SPARSE_PAGE_SIZE * 5 + 1);
+    ck_assert(ecs_sparse_map_next(&map, ECS_SPARSE_PAGE_SIZE * 5 + 2) == -1);
+    ecs_sparse_map_free_resources(&map);
+}
+END_TEST
+
+START_TEST(sparse_map_frees_empty_pages) {
+    EcsSparseMap map;
+    ecs_sparse_map_init(&map);
+    ecs_sparse_map_set(&map, 3, 1);
+    ecs_sparse_map_set(&map, ECS_SPARSE_PAGE_SIZE * 2 + 1, 2);
+    ecs_sparse_map_set(&map, ECS_SPARSE_PAGE_SIZE * 2 + 2, 3);
+    ecs_sparse_map_set(&map, ECS_SPARSE_PAGE_SIZE * 20, 4);
+
+    // Overwriting or removing a missing id doesn't change the number of ids in a page.
+    ecs_sparse_map_set(&map, ECS_SPARSE_PAGE_SIZE * 2 + 1, 5);
+    ecs_sparse_map_remove(&map, ECS_SPARSE_PAGE_SIZE * 2 + 3);
+
+    // The page that was emptied last is kept, so setting and removing the same id doesn't reallocate it.
+    ecs_sparse_map_remove(&map, ECS_SPARSE_PAGE_SIZE * 2 + 1);
+    ecs_sparse_map_remove(&map, ECS_SPARSE_PAGE_SIZE * 2 + 2);
+    int* kept = map.pages[2];
+    ck_assert_msg(kept != ___ecs_sparse_null_page, "Empty page wasn't kept");
+    ecs_sparse_map_set(&map, ECS_SPARSE_PAGE_SIZE * 2 + 1, 6);
+    ecs_sparse_map_remove(&map, ECS_SPARSE_PAGE_SIZE * 2 + 1);
+    ck_assert(map.pages[2] == kept);
+    ck_assert(ecs_sparse_map_get(&map, ECS_SPARSE_PAGE_SIZE * 2 + 1) == -1);
+
+    // Emptying another page frees the kept one. Freeing the highest page shrinks the page array.
+    int page_count = map.page_count;
+    ecs_sparse_map_remove(&map, ECS_SPARSE_PAGE_SIZE * 20);
+    ck_assert_msg(map.pages[2] == ___ecs_sparse_null_page, "Kept page wasn't freed");
+    ecs_sparse_map_remove(&map, 3);
+    ck_assert_msg(map.page_count < page_count, "Page array didn't shrink");
+    ck_assert(ecs_sparse_map_next(&map, 0) == -1);
+
+    // The map can still grow again afterwards.
+    ecs_sparse_map_set(&map, ECS_SPARSE_PAGE_SIZE * 30, 7);
+    ecs_sparse_map_set(&map, 1, 8);
+    ck_assert(ecs_sparse_map_get(&map, ECS_SPARSE_PAGE_SIZE * 30) == 7);
+    ck_assert(ecs_sparse_map_get(&map, 1) == 8);
+    ecs_sparse_map_free_resources(&map);
+}
+END_TEST
+
+int main(void) {
+    int number_failed;
+
+    Suite* s = suite_create("Sparse Map");
+    TCase* tc_sparse_map = tcase_create("Sparse Map");
+
+    tcase_add_test(tc_sparse_map, sparse_map_missing_id);
+    tcase_add_test(tc_sparse_map, sparse_map_set_get_remove);
+    tcase_add_test(tc_sparse_map, sparse_map_next_skips_empty_pages);
+    tcase_add_test(tc_sparse_map, sparse_map_frees_empty_pages);
+
+    suite_add_tcase(s, tc_sparse_map);
+
+    SRunner* sr = srunner_create(s);
+
+    srunner_run_all(sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+
+    return number_failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
\ No newline at end of file
@@ -20,6 +20,72 @@ void entity_update(EcsEntitySystem* system, float state, EcsEntity entity) {
     *item = true;
 }
 
+int changed_count;
+
+void changed_update(EcsComponentSystem* system, float state, void* item) {
+    changed_count++;
+}
+
+void entity_changed_update(EcsEntitySystem* system, float state, EcsEntity entity) {
+    changed_count++;
+}
+
+void parallel_update(EcsComponentSystem* system, float state, void* item) {
+    *(int*)item *= 2;
+}
+
+void entity_parallel_update(EcsEntitySystem* system, float state, EcsEntity entity) {
+    *(int*)ecs_component_try_get(entity, int_component) += 1;
+}
+
+// Only counts the entities, so systems using it only read their components.
+static int shared_set_visits;
+
+void shared_set_update(EcsEntitySystem* system, float state, EcsEntity entity) {
+    shared_set_visits++;
+}
+
+// The writer and reader never run at the same time, so they can share a counter.
+// The other systems can run alongside them, so each one gets its own counter.
+static int schedule_step;
+static int writer_step;
+static int reader_step;
+static int other1_count;
+static int other2_count;
+
+void writer_update(EcsActionSystem* system, float state) {
+    writer_step = ++schedule_step;
+}
+
+void reader_update(EcsActionSystem* system, float state) {
+    reader_step = ++schedule_step;
+}
+
+void other1_update(EcsActionSystem* system, float state) {
+    other1_count++;
+}
+
+void other2_update(EcsActionSystem* system, float state) {
+    other2_count++;
+}
+
+int batch_calls;
+
+void batch_update(EcsComponentSystem* system, float state, void* first, int count) {
+    int* values = first;
+    for(int i = 0; i < count; i++)
+        values[i] += 1;
+
+    batch_calls++;
+}
+
+void entity_batch_update(EcsEntitySystem* system, float state, EcsEntity* entities, int count) {
+    for(int i = 0; i < count; i++)
+        *(int*)ecs_component_try_get(entities[i], int_component) += 1;
+
+    batch_calls++;
+}
+
 void bool_component_constructor(void* item) {
     *(bool*)item = false;
 }
@@ -219,6 +285,373 @@ START_TEST(entity_disabled_update_none) {
 }
 END_TEST
 
+START_TEST(component_changed_only_update_calls_changed) {
+    EcsComponentManager* tracked = ecs_component_define(sizeof(int), NULL, NULL);
+    ck_assert(ecs_component_track_changes(tracked) == ECS_RESULT_SUCCESS);
+
+    EcsWorld world = ecs_world_init();
+    EcsEntity entities[4];
+    for(int i = 0; i < 4; i++) {
+        entities[i] = ecs_create_entity(world);
+        ecs_component_set(entities[i], tracked);
+    }
+
+    EcsComponentSystem system;
+    ecs_component_system_init(&system, world, tracked, changed_update, NULL, NULL);
+    ck_assert(ecs_component_system_track_changes(&system) == ECS_RESULT_SUCCESS);
+
+    changed_count = 0;
+    ecs_system_update(&system, 0);
+    ck_assert_msg(changed_count == 4, "First update didn't visit every component");
+
+    changed_count = 0;
+    ecs_system_update(&system, 0);
+    ck_assert_msg(changed_count == 0, "Unchanged components were visited");
+
+    int* value;
+    ecs_component_get_mut(entities[2], tracked, &value);
+    *value = 5;
+    changed_count = 0;
+    ecs_system_update(&system, 0);
+    ck_assert_msg(changed_count == 1, "Changed component wasn't visited");
+
+    ecs_system_free_resources(&system);
+    ecs_world_free(world);
+    ecs_component_free(tracked);
+}
+END_TEST
+
+START_TEST(entity_changed_only_update_calls_changed) {
+    EcsComponentManager* tracked = ecs_component_define(sizeof(int), NULL, NULL);
+    ecs_component_track_changes(tracked);
+
+    EcsEntitySetBuilder* builder = ecs_entity_set_builder_init();
+    ecs_entity_set_with(builder, tracked);
+
+    EcsWorld world = ecs_world_init();
+    EcsEntity entities[4];
+    for(int i = 0; i < 4; i++) {
+        entities[i] = ecs_create_entity(world);
+        ecs_component_set(entities[i], tracked);
+    }
+
+    EcsEntitySystem system;
+    ecs_entity_system_init(&system, world, builder, true, entity_changed_update, NULL, NULL);
+    ck_assert(ecs_entity_system_track_changes(&system, bool_component) == ECS_RESULT_INVALID_STATE);
+    ck_assert(ecs_entity_system_track_changes(&system, tracked) == ECS_RESULT_SUCCESS);
+
+    changed_count = 0;
+    ecs_system_update(&system, 0);
+    ck_assert(changed_count == 4);
+
+    // Removing an entity moves the last component, which must keep its version.
+    ecs_component_mark_changed(entities[1], tracked);
+    ecs_entity_free(entities[0]);
+    changed_count = 0;
+    ecs_system_update(&system, 0);
+    ck_assert(changed_count == 1);
+    ck_assert(!ecs_component_changed_since(entities[3], tracked, system.last_tick));
+
+    ecs_system_free_resources(&system);
+    ecs_world_free(world);
+    ecs_component_free(tracked);
+}
+END_TEST
+
+START_TEST(component_parallel_update_calls_all) {
+    EcsComponentManager* chunked = ecs_component_define_chunked(sizeof(int), 6, NULL, NULL);
+    EcsWorld world = ecs_world_init();
+    EcsEntity entities[1000];
+    for(int i = 0; i < 1000; ++i) {
+        entities[i] = ecs_create_entity(world);
+        *(int*)ecs_component_set(entities[i], chunked) = i;
+    }
+
+    EcsJobPool* pool = ecs_job_pool_init(3);
+    EcsComponentSystem system;
+    ecs_component_system_init(&system, world, chunked, parallel_update, NULL, NULL);
+    ecs_component_system_set_parallel(&system, pool, 10);
+    ecs_system_update(&system, 0);
+
+    for(int i = 0; i < 1000; ++i)
+        ck_assert_msg(*(int*)ecs_component_try_get(entities[i], chunked) == i * 2, "Parallel component system missed a component");
+
+    ecs_system_free_resources(&system);
+    ecs_job_pool_free(pool);
+    ecs_world_free(world);
+    ecs_component_free(chunked);
+}
+END_TEST
+
+START_TEST(entity_parallel_update_calls_all) {
+    EcsEntitySetBuilder* builder = ecs_entity_set_builder_init();
+    ecs_entity_set_with(builder, int_component);
+
+    EcsWorld world = ecs_world_init();
+    EcsEntity entities[1000];
+    for(int i = 0; i < 1000; ++i) {
+        entities[i] = ecs_create_entity(world);
+        *(int*)ecs_component_set(entities[i], int_component) = i;
+    }
+
+    EcsJobPool* pool = ecs_job_pool_init(3);
+    EcsEntitySystem system;
+    ecs_entity_system_init(&system, world, builder, true, entity_parallel_update, NULL, NULL);
+    ecs_entity_system_set_parallel(&system, pool, 0);
+    ecs_system_update(&system, 0);
+
+    for(int i = 0; i < 1000; ++i)
+        ck_assert_msg(*(int*)ecs_component_try_get(entities[i], int_component) == i + 1, "Parallel entity system missed an entity");
+
+    ecs_system_free_resources(&system);
+    ecs_job_pool_free(pool);
+    ecs_world_free(world);
+}
+END_TEST
+
+START_TEST(scheduler_orders_conflicting_systems) {
+    EcsJobPool* pool = ecs_job_pool_init(3);
+    EcsActionSystem reader, writer, other1, other2;
+    ecs_action_system_init(&reader, reader_update, NULL, NULL);
+    ecs_action_system_init(&writer, writer_update, NULL, NULL);
+    ecs_action_system_init(&other1, other1_update, NULL, NULL);
+    ecs_action_system_init(&other2, other2_update, NULL, NULL);
+
+    EcsSchedulerSystem scheduler;
+    ecs_scheduler_system_init(&scheduler, pool, NULL, NULL, false);
+    ecs_scheduler_system_add(&scheduler, (EcsSystem*)&writer, NULL, 0, &int_component, 1);
+    ecs_scheduler_system_add(&scheduler, (EcsSystem*)&other1, &bool_component, 1, NULL, 0);
+    ecs_scheduler_system_add(&scheduler, (EcsSystem*)&reader, &int_component, 1, NULL, 0);
+    ecs_scheduler_system_add(&scheduler, (EcsSystem*)&other2, &bool_component, 1, NULL, 0);
+
+    ck_assert_msg(scheduler.base.type == ECS_SYSTEM_TYPE_SCHEDULER, "Scheduler has the wrong type");
+
+    for(int i = 0; i < 20; ++i) {
+        schedule_step = 0;
+        ecs_system_update(&scheduler, 0);
+        ck_assert_msg(writer_step < reader_step, "Reader ran before the writer it depends on");
+    }
+
+    ck_assert_msg(other1_count == 20 && other2_count == 20, "Scheduler did not update every system");
+    ck_assert_msg(scheduler.level_count == 2, "Independent systems were not scheduled together");
+
+    ecs_system_free_resources(&scheduler);
+    ecs_system_free_resources(&reader);
+    ecs_system_free_resources(&writer);
+    ecs_system_free_resources(&other1);
+    ecs_system_free_resources(&other2);
+    ecs_job_pool_free(pool);
+}
+END_TEST
+
+START_TEST(scheduler_runs_parallel_subsystems) {
+    EcsWorld world = ecs_world_init();
+    EcsEntity entities[200];
+    for(int i = 0; i < 200; ++i) {
+        entities[i] = ecs_create_entity(world);
+        *(int*)ecs_component_set(entities[i], int_component) = i;
+    }
+
+    EcsJobPool* pool = ecs_job_pool_init(2);
+    EcsComponentSystem* doubler = ecs_malloc(sizeof(EcsComponentSystem));
+    ecs_component_system_init(doubler, world, int_component, parallel_update, NULL, NULL);
+    ecs_component_system_set_parallel(doubler, pool, 8);
+
+    EcsActionSystem* exclusive = ecs_malloc(sizeof(EcsActionSystem));
+    ecs_action_system_init(exclusive, action_update, NULL, NULL);
+
+    EcsSchedulerSystem scheduler;
+    ecs_scheduler_system_init(&scheduler, pool, NULL, NULL, true);
+    ecs_scheduler_system_add(&scheduler, (EcsSystem*)doubler, NULL, 0, &int_component, 1);
+    ecs_scheduler_system_add_exclusive(&scheduler, (EcsSystem*)exclusive);
+    ecs_system_update(&scheduler, 0);
+
+    for(int i = 0; i < 200; ++i)
+        ck_assert_msg(*(int*)ecs_component_try_get(entities[i], int_component) == i * 2, "Nested parallel system missed a component");
+    ck_assert(action_count == 1);
+
+    ecs_system_free_resources(&scheduler);
+    ecs_job_pool_free(pool);
+    ecs_world_free(world);
+}
+END_TEST
+
+START_TEST(scheduler_serializes_changed_only_systems) {
+    EcsComponentManager* tracked = ecs_component_define(sizeof(int), NULL, NULL);
+    ck_assert(ecs_component_track_changes(tracked) == ECS_RESULT_SUCCESS);
+
+    EcsWorld world = ecs_world_init();
+    EcsJobPool* pool = ecs_job_pool_init(2);
+
+    EcsComponentSystem changed;
+    ecs_component_system_init(&changed, world, tracked, changed_update, NULL, NULL);
+    ck_assert(ecs_component_system_track_changes(&changed) == ECS_RESULT_SUCCESS);
+
+    EcsActionSystem other;
+    ecs_action_system_init(&other, action_update, NULL, NULL);
+
+    // The systems don't share any component types, but the changed-only system advances the world tick.
+    EcsSchedulerSystem scheduler;
+    ecs_scheduler_system_init(&scheduler, pool, NULL, NULL, false);
+    ecs_scheduler_system_add(&scheduler, (EcsSystem*)&changed, &tracked, 1, NULL, 0);
+    ecs_scheduler_system_add(&scheduler, (EcsSystem*)&other, &bool_component, 1, NULL, 0);
+
+    unsigned int tick = ecs_world_get_tick(world);
+    ecs_system_update(&scheduler, 0);
+    ck_assert_msg(scheduler.level_count == 2, "Changed-only system wasn't scheduled exclusively");
+    ck_assert(ecs_world_get_tick(world) == tick + 1);
+
+    ecs_system_free_resources(&scheduler);
+    ecs_system_free_resources(&changed);
+    ecs_system_free_resources(&other);
+    ecs_job_pool_free(pool);
+    ecs_world_free(world);
+    ecs_component_free(tracked);
+}
+END_TEST
+
+START_TEST(scheduler_serializes_shared_entity_sets) {
+    EcsWorld world = ecs_world_init();
+    for(int i = 0; i < 100; ++i)
+        ecs_component_set(ecs_create_entity(world), int_component);
+
+    // Identical builders share a set, and getting its entities updates it, so the readers can't run together.
+    EcsEntitySystem first, second;
+    for(int i = 0; i < 2; ++i) {
+        EcsEntitySetBuilder* builder = ecs_entity_set_builder_init();
+        ecs_entity_set_with(builder, int_component);
+        ecs_entity_system_init(i == 0 ? &first : &second, world, builder, true, shared_set_update, NULL, NULL);
+    }
+    ck_assert(first.entities == second.entities);
+
+    EcsJobPool* pool = ecs_job_pool_init(2);
+    EcsSchedulerSystem scheduler;
+    ecs_scheduler_system_init(&scheduler, pool, NULL, NULL, false);
+    ecs_scheduler_system_add(&scheduler, (EcsSystem*)&first, &int_component, 1, NULL, 0);
+    ecs_scheduler_system_add(&scheduler, (EcsSystem*)&second, &int_component, 1, NULL, 0);
+
+    shared_set_visits = 0;
+    for(int i = 0; i < 20; ++i) {
+        // New entities change the set between updates, so both systems have to bring it up to date.
+        ecs_component_set(ecs_create_entity(world), int_component);
+        ecs_system_update(&scheduler, 0);
+    }
+
+    ck_assert_msg(scheduler.level_count == 2, "Systems with a shared set were scheduled together");
+
+    // Update i visits 101 + i entities in each system.
+    ck_assert(shared_set_visits == 2 * (20 * 101 + 190));
+
+    ecs_system_free_resources(&scheduler);
+    ecs_system_free_resources(&first);
+    ecs_system_free_resources(&second);
+    ecs_job_pool_free(pool);
+    ecs_world_free(world);
+}
+END_TEST
+
+START_TEST(scheduler_reads_missing_pools_in_parallel) {
+    EcsWorld world = ecs_world_init();
+    EcsJobPool* pool = ecs_job_pool_init(4);
+
+    // None of the component types has a pool on the world yet, so reading them must not create one from the worker threads.
+    EcsComponentManager* managers[16];
+    EcsComponentSystem systems[16];
+    EcsSchedulerSystem scheduler;
+    ecs_scheduler_system_init(&scheduler, pool, NULL, NULL, false);
+    for(int i = 0; i < 16; ++i) {
+        managers[i] = ecs_component_define(sizeof(int), NULL, NULL);
+        ecs_component_system_init(systems + i, world, managers[i], changed_update, NULL, NULL);
+        ecs_scheduler_system_add(&scheduler, (EcsSystem*)(systems + i), managers + i, 1, NULL, 0);
+    }
+
+    for(int i = 0; i < 10; ++i)
+        ecs_system_update(&scheduler, 0);
+
+    ck_assert_msg(scheduler.level_count == 1, "Readers weren't scheduled together");
+    for(int i = 0; i < 16; ++i) {
+        ck_assert_msg(ecs_component_find_pool(world, managers[i]) == NULL, "Reading a component type created its pool");
+        ecs_system_free_resources(systems + i);
+    }
+
+    ecs_system_free_resources(&scheduler);
+    ecs_job_pool_free(pool);
+    ecs_world_free(world);
+    for(int i = 0; i < 16; ++i)
+        ecs_component_free(managers[i]);
+}
+END_TEST
+
+START_TEST(component_batch_update_calls_runs) {
+    EcsComponentManager* chunked = ecs_component_define_chunked(sizeof(int), 4, NULL, NULL);
+    ck_assert(ecs_component_track_changes(chunked) == ECS_RESULT_SUCCESS);
+
+    EcsWorld world = ecs_world_init();
+    EcsEntity entities[10];
+    for(int i = 0; i < 10; i++) {
+        entities[i] = ecs_create_entity(world);
+        *(int*)ecs_component_set(entities[i], chunked) = i;
+    }
+
+    EcsComponentSystem system;
+    ecs_component_system_init_batch(&system, world, chunked, batch_update, NULL, NULL);
+
+    batch_calls = 0;
+    ecs_system_update(&system, 0);
+    ck_assert_msg(batch_calls == 3, "Batch update wasn't called once per chunk");
+    for(int i = 0; i < 10; i++)
+        ck_assert_msg(*(int*)ecs_component_try_get(entities[i], chunked) == i + 1, "Batch update missed a component");
+
+    // Only the changed components are visited, split into runs around the unchanged ones.
+    ck_assert(ecs_component_system_track_changes(&system) == ECS_RESULT_SUCCESS);
+    ecs_system_update(&system, 0);
+    ecs_component_mark_changed(entities[0], chunked);
+    ecs_component_mark_changed(entities[1], chunked);
+    ecs_component_mark_changed(entities[3], chunked);
+
+    batch_calls = 0;
+    ecs_system_update(&system, 0);
+    ck_assert_msg(batch_calls == 2, "Changed components weren't split into runs");
+    ck_assert_msg(*(int*)ecs_component_try_get(entities[1], chunked) == 4, "Changed component wasn't updated");
+    ck_assert_msg(*(int*)ecs_component_try_get(entities[2], chunked) == 4, "Unchanged component was updated");
+
+    ecs_system_free_resources(&system);
+    ecs_world_free(world);
+    ecs_component_free(chunked);
+}
+END_TEST
+
+START_TEST(entity_batch_update_calls_spans) {
+    EcsEntitySetBuilder* builder = ecs_entity_set_builder_init();
+    ecs_entity_set_with(builder, int_component);
+
+    EcsWorld world = ecs_world_init();
+    EcsEntity entities[100];
+    for(int i = 0; i < 100; i++) {
+        entities[i] = ecs_create_entity(world);
+        *(int*)ecs_component_set(entities[i], int_component) = i;
+    }
+
+    EcsEntitySystem system;
+    ecs_entity_system_init_batch(&system, world, builder, true, entity_batch_update, NULL, NULL);
+
+    batch_calls = 0;
+    ecs_system_update(&system, 0);
+    ck_assert_msg(batch_calls == 1, "Entity batch update wasn't called with a single span");
+
+    EcsJobPool* pool = ecs_job_pool_init(2);
+    ecs_entity_system_set_parallel(&system, pool, 10);
+    ecs_system_update(&system, 0);
+
+    for(int i = 0; i < 100; i++)
+        ck_assert_msg(*(int*)ecs_component_try_get(entities[i], int_component) == i + 2, "Entity batch update missed an entity");
+
+    ecs_system_free_resources(&system);
+    ecs_job_pool_free(pool);
+    ecs_world_free(world);
+}
+END_TEST
+
 int main(void) {
     int number_failed;
 
@@ -238,6 +671,17 @@ int main(void) {
     tcase_add_test(tc_system, entity_enabled_update_all);
     tcase_add_test(tc_system, entity_enabled_update_some);
     tcase_add_test(tc_system, entity_disabled_update_none);
+    tcase_add_test(tc_system, component_changed_only_update_calls_changed);
+    tcase_add_test(tc_system, entity_changed_only_update_calls_changed);
+    tcase_add_test(tc_system, component_parallel_update_calls_all);
+    tcase_add_test(tc_system, entity_parallel_update_calls_all);
+    tcase_add_test(tc_system, scheduler_orders_conflicting_systems);
+    tcase_add_test(tc_system, component_batch_update_calls_runs);
+    tcase_add_test(tc_system, entity_batch_update_calls_spans);
+    tcase_add_test(tc_system, scheduler_runs_parallel_subsystems);
+    tcase_add_test(tc_system, scheduler_serializes_changed_only_systems);
+    tcase_add_test(tc_system, scheduler_serializes_shared_entity_sets);
+    tcase_add_test(tc_system, scheduler_reads_missing_pools_in_parallel);
 
     suite_add_tcase(s, tc_system);
 
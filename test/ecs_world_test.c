@@ -112,6 +112,77 @@ START_TEST(entity_can_be_disabled) {
 }
 END_TEST
 
+START_TEST(handle_detects_reused_entity) {
+    EcsWorld world = ecs_world_init();
+    EcsEntity entity = ecs_create_entity(world);
+    EcsHandle handle = ecs_entity_get_handle(entity);
+
+    ck_assert_msg(ecs_handle_is_alive(handle), "New entity handle not alive");
+    EcsEntity resolved;
+    ck_assert_msg(ecs_handle_get_alive_entity(handle, &resolved), "Could not resolve handle");
+    ck_assert_msg(resolved.world == entity.world && resolved.id == entity.id, "Handle resolved to the wrong entity");
+
+    ecs_entity_free(entity);
+    ck_assert_msg(!ecs_handle_is_alive(handle), "Freed entity handle still alive");
+
+    EcsEntity reused = ecs_create_entity(world);
+    ck_assert_msg(reused.id == entity.id, "Entity id wasn't reused");
+    ck_assert_msg(!ecs_handle_is_alive(handle), "Handle aliased a reused entity");
+    ck_assert_msg(ecs_handle_is_alive(ecs_entity_get_handle(reused)), "Reused entity handle not alive");
+    ck_assert_msg(ecs_entity_get_handle(reused) != handle, "Reused entity has the same handle");
+
+    ecs_world_free(world);
+}
+END_TEST
+
+START_TEST(handle_of_freed_world_is_not_alive) {
+    EcsWorld world = ecs_world_init();
+    EcsEntity entity = ecs_create_entity(world);
+    EcsHandle handle = ecs_entity_get_handle(entity);
+    ecs_world_free(world);
+    ck_assert_msg(!ecs_handle_is_alive(handle), "Handle to an entity of a freed world alive");
+
+    EcsWorld reused = ecs_world_init();
+    ck_assert_msg(reused == world, "World id wasn't reused");
+    EcsEntity other = ecs_create_entity(reused);
+    ck_assert(other.id == entity.id);
+    ck_assert_msg(!ecs_handle_is_alive(handle), "Handle aliased an entity of a reused world");
+    ck_assert(ecs_handle_is_alive(ecs_entity_get_handle(other)));
+    ecs_world_free(reused);
+}
+END_TEST
+
+START_TEST(handle_requires_world_to_fit) {
+    int count = 1 << ECS_HANDLE_WORLD_BITS;
+    EcsWorld* worlds = malloc(sizeof(EcsWorld) * count);
+    for(int i = 0; i < count; i++)
+        worlds[i] = ecs_world_init();
+
+    EcsWorld last = worlds[count - 1];
+    ck_assert(last >= count);
+    EcsEntity entity = ecs_create_entity(last);
+    ck_assert_msg(ecs_entity_get_handle(entity) == ECS_HANDLE_NULL, "Handle truncated the world id");
+
+    for(int i = 0; i < count; i++)
+        ecs_world_free(worlds[i]);
+    free(worlds);
+}
+END_TEST
+
+START_TEST(handle_of_invalid_entity_is_not_alive) {
+    ck_assert_msg(!ecs_handle_is_alive(ECS_HANDLE_NULL), "Null handle alive");
+
+    EcsWorld world = ecs_world_init();
+    EcsEntity entity = ecs_create_entity(world);
+    ecs_entity_free(entity);
+    ck_assert_msg(ecs_entity_get_handle(entity) == ECS_HANDLE_NULL, "Freed entity returned a handle");
+
+    EcsEntity invalid = { world, 47 };
+    ck_assert_msg(!ecs_handle_is_alive(ecs_handle_pack(invalid.world, invalid.id, 0)), "Handle to invalid entity alive");
+    ecs_world_free(world);
+}
+END_TEST
+
 int main(void) {
     int number_failed;
 
@@ -128,6 +199,10 @@ int main(void) {
     tcase_add_test(tc_world, create_entity_returns_an_entity);
     tcase_add_test(tc_world, free_invalid_entity_should_fail);
     tcase_add_test(tc_world, entity_can_be_disabled);
+    tcase_add_test(tc_world, handle_detects_reused_entity);
+    tcase_add_test(tc_world, handle_of_invalid_entity_is_not_alive);
+    tcase_add_test(tc_world, handle_of_freed_world_is_not_alive);
+    tcase_add_test(tc_world, handle_requires_world_to_fit);
 
     suite_add_tcase(s, tc_world);
 